@@ -31,6 +31,9 @@ echo ">>>>>>>>> Run tests in RELEASE"
 #./tests/sha256Test
 #./tests/pageRankCalculationTest
 ./tests/pageRankPerformanceTest
+./tests/concurrentPageIdMapPerformanceTest
+./tests/instrumentationTest
+./tests/tracerTest
 
 ./tests/e2eTest < ./tests/e2eScenario.txt
 for i in 1 2 3 4 8; do ./tests/e2eTest $i < ./tests/e2eScenario.txt; done
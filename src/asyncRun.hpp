@@ -0,0 +1,138 @@
+#ifndef SRC_ASYNCRUN_HPP_
+#define SRC_ASYNCRUN_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+
+#include "runBudget.hpp"
+
+// Progress of a run, published once per iteration by the run and readable
+// from any thread without locking (a sequence lock: readers retry while an
+// update is being written).
+class RunProgress {
+public:
+    struct Snapshot {
+        uint32_t iterations;
+        double residual;
+        // Of the last iteration.
+        double edgesPerSecond;
+    };
+
+    // Called by the run after every iteration, holding up the next one, so it
+    // should return quickly.
+    using Callback = std::function<void(Snapshot const&)>;
+
+    RunProgress(Callback callbackArg = nullptr)
+        : callback(std::move(callbackArg))
+        , sequence(0)
+        , iterations(0)
+        , residual(std::numeric_limits<double>::infinity())
+        , edgesPerSecond(0)
+        , numEdges(0)
+        , lastUpdate()
+    {
+    }
+
+    RunProgress(RunProgress const&) = delete;
+    RunProgress& operator=(RunProgress const&) = delete;
+
+    Snapshot get() const
+    {
+        while (true) {
+            uint64_t before = this->sequence.load(std::memory_order_acquire);
+            Snapshot snapshot {
+                this->iterations.load(std::memory_order_relaxed),
+                this->residual.load(std::memory_order_relaxed),
+                this->edgesPerSecond.load(std::memory_order_relaxed),
+            };
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (before % 2 == 0 && this->sequence.load(std::memory_order_relaxed) == before)
+                return snapshot;
+        }
+    }
+
+    // Called by the run, which then is the only writer.
+    void start(uint64_t numEdgesArg)
+    {
+        this->numEdges = numEdgesArg;
+        this->lastUpdate = std::chrono::steady_clock::now();
+    }
+
+    void update(uint32_t iterationsArg, double residualArg)
+    {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - this->lastUpdate).count();
+        this->lastUpdate = now;
+        Snapshot snapshot { iterationsArg, residualArg, seconds > 0 ? this->numEdges / seconds : 0 };
+
+        uint64_t before = this->sequence.load(std::memory_order_relaxed);
+        this->sequence.store(before + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        this->iterations.store(snapshot.iterations, std::memory_order_relaxed);
+        this->residual.store(snapshot.residual, std::memory_order_relaxed);
+        this->edgesPerSecond.store(snapshot.edgesPerSecond, std::memory_order_relaxed);
+        this->sequence.store(before + 2, std::memory_order_release);
+
+        if (this->callback)
+            this->callback(snapshot);
+    }
+
+private:
+    Callback callback;
+    // Odd while an update is being written.
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint32_t> iterations;
+    std::atomic<double> residual;
+    std::atomic<double> edgesPerSecond;
+    // Only used by the run.
+    uint64_t numEdges;
+    std::chrono::steady_clock::time_point lastUpdate;
+};
+
+// A run going on in the background. The network or graph of the run has to
+// outlive the handle, whose destructor waits for the run to finish.
+class AsyncRun {
+public:
+    AsyncRun(std::shared_ptr<RunBudget> budgetArg, std::shared_ptr<RunProgress> progressArg, std::future<BestEffortResult> resultArg)
+        : budget(std::move(budgetArg))
+        , progress(std::move(progressArg))
+        , result(std::move(resultArg))
+    {
+    }
+
+    AsyncRun(AsyncRun&&) = default;
+    AsyncRun& operator=(AsyncRun&&) = default;
+
+    RunProgress::Snapshot getProgress() const
+    {
+        return this->progress->get();
+    }
+
+    bool isReady() const
+    {
+        return this->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    // The run stops at its next iteration boundary.
+    void cancel()
+    {
+        this->budget->cancel();
+    }
+
+    // Waits for the run, can be called once.
+    BestEffortResult get()
+    {
+        return this->result.get();
+    }
+
+private:
+    std::shared_ptr<RunBudget> budget;
+    std::shared_ptr<RunProgress> progress;
+    std::future<BestEffortResult> result;
+};
+
+#endif /* SRC_ASYNCRUN_HPP_ */
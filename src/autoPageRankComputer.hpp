@@ -0,0 +1,195 @@
+#ifndef SRC_AUTOPAGERANKCOMPUTER_HPP_
+#define SRC_AUTOPAGERANKCOMPUTER_HPP_
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+#include "immutable/pageRankComputer.hpp"
+#include "machineCalibration.hpp"
+#include "multiThreadedPageRankComputer.hpp"
+#include "preparedGraph.hpp"
+#include "singleThreadedPageRankComputer.hpp"
+
+// What AutoPageRankComputer runs a graph with.
+struct AutoPlan {
+    // 1 without compressed in-links is SingleThreadedPageRankComputer,
+    // anything else MultiThreadedPageRankComputer.
+    uint32_t numThreads;
+    bool compressEdges;
+    std::string reason;
+};
+
+// Picks the engine, the in-link kernel and the number of threads for every
+// graph from its pages and in-links and the MachineCalibration of the
+// machine. A run is estimated as expectedIterations iterations over pages
+// plus in-links, sped up by the threads as much as measured, three barrier
+// rounds per iteration and starting the threads; the cheapest plan wins, with fewer threads on a
+// tie, and never more threads than the hardware has. The compressed kernel is
+// only considered for graphs at least as big as the calibration graph, as
+// smaller ones stay in cache. Networks are prepared with the in-links of the
+// chosen kernel, prepared graphs run with the in-links they have.
+//
+// Every decision goes to `log` and, when PAGERANK_AUTO_LOG is set, to stderr.
+// Non-zero numThreads and a non-automatic kernel of `forced` override the
+// estimate, the machine is only calibrated (once per process) when needed.
+class AutoPageRankComputer : public PageRankComputer {
+public:
+    static constexpr uint32_t expectedIterations = 30;
+
+    enum class Kernel { automatic,
+        plain,
+        compressed };
+
+    struct Override {
+        uint32_t numThreads;
+        Kernel kernel;
+    };
+
+    using Log = std::function<void(std::string const&)>;
+
+    AutoPageRankComputer(Override forcedArg = { 0, Kernel::automatic }, Log logArg = nullptr)
+        : forced(forcedArg)
+        , log(std::move(logArg)) {};
+
+    std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha, uint32_t iterations, double tolerance) const
+    {
+        auto chosen = this->planFor(network.getSize(), countLinks(network));
+        PreparedGraph graph(network, chosen.numThreads);
+        if (chosen.compressEdges)
+            graph.compressEdges(chosen.numThreads);
+        return makeEngine(chosen)->computeForGraph(graph, alpha, iterations, tolerance);
+    }
+
+    std::vector<PageIdAndRank> computeTopK(Network const& network, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        auto chosen = this->planFor(network.getSize(), countLinks(network));
+        PreparedGraph graph(network, chosen.numThreads);
+        if (chosen.compressEdges)
+            graph.compressEdges(chosen.numThreads);
+        return makeEngine(chosen)->computeTopKForGraph(graph, alpha, iterations, tolerance, k);
+    }
+
+    std::vector<PageIdAndRank> computeForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance) const
+    {
+        return makeEngine(this->planFor(graph))->computeForGraph(graph, alpha, iterations, tolerance);
+    }
+
+    std::vector<PageIdAndRank> computeTopKForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        return makeEngine(this->planFor(graph))->computeTopKForGraph(graph, alpha, iterations, tolerance, k);
+    }
+
+    std::string getName() const
+    {
+        std::string name = "AutoPageRankComputer";
+        if (this->forced.numThreads > 0)
+            name += "[threads:" + std::to_string(this->forced.numThreads) + "]";
+        if (this->forced.kernel != Kernel::automatic)
+            name += this->forced.kernel == Kernel::compressed ? "[compressed]" : "[plain]";
+        return name;
+    }
+
+    static AutoPlan plan(uint64_t numPages, uint64_t numEdges, Override forced, MachineCalibration const& calibration)
+    {
+        uint64_t units = numPages + numEdges;
+        std::vector<bool> kernels;
+        if (forced.kernel != Kernel::automatic)
+            kernels = { forced.kernel == Kernel::compressed };
+        else if (units >= MachineCalibration::calibrationUnits && calibration.compressedSecondsPerUnit < calibration.plainSecondsPerUnit)
+            kernels = { false, true };
+        else
+            kernels = { false };
+        uint32_t minThreads = forced.numThreads > 0 ? forced.numThreads : 1;
+        uint32_t maxThreads = forced.numThreads > 0 ? forced.numThreads : calibration.hardwareThreads;
+
+        AutoPlan best { 0, false, "" };
+        double bestSeconds = 0;
+        for (uint32_t numThreads = minThreads; numThreads <= maxThreads; ++numThreads) {
+            for (bool compressEdges : kernels) {
+                double seconds = estimateSeconds(units, numThreads, compressEdges, calibration);
+                if (best.numThreads == 0 || seconds < bestSeconds) {
+                    best = { numThreads, compressEdges, "" };
+                    bestSeconds = seconds;
+                }
+            }
+        }
+
+        std::ostringstream reason;
+        reason << "pages=" << numPages << ", inLinks=" << numEdges;
+        if (forced.numThreads > 0 || forced.kernel != Kernel::automatic)
+            reason << ", overridden";
+        if (forced.numThreads == 0 || forced.kernel == Kernel::automatic)
+            reason << ", estimated " << bestSeconds << "s for " << expectedIterations << " iterations (single thread "
+                   << estimateSeconds(units, 1, false, calibration) << "s), " << calibration.describe();
+        best.reason = reason.str();
+        return best;
+    }
+
+    // Estimated seconds of expectedIterations iterations.
+    static double estimateSeconds(uint64_t units, uint32_t numThreads, bool compressEdges, MachineCalibration const& calibration)
+    {
+        double secondsPerUnit = compressEdges ? calibration.compressedSecondsPerUnit : calibration.plainSecondsPerUnit;
+        double seconds = expectedIterations * units * secondsPerUnit / calibration.speedup(numThreads);
+        // Compressing costs about a plain iteration.
+        if (compressEdges)
+            seconds += units * calibration.plainSecondsPerUnit;
+        if (numThreads > 1)
+            seconds += expectedIterations * 3 * calibration.barrierSeconds + numThreads * calibration.threadStartSeconds;
+        return seconds;
+    }
+
+private:
+    Override forced;
+    Log log;
+
+    AutoPlan planFor(uint64_t numPages, uint64_t numEdges) const
+    {
+        return planFor(numPages, numEdges, this->forced);
+    }
+
+    // A prepared graph keeps its in-links, only the threads are planned.
+    AutoPlan planFor(PreparedGraph const& graph) const
+    {
+        return planFor(graph.getSize(), graph.getNumEdges(), { this->forced.numThreads, graph.hasCompressedEdges() ? Kernel::compressed : Kernel::plain });
+    }
+
+    AutoPlan planFor(uint64_t numPages, uint64_t numEdges, Override overridden) const
+    {
+        // A fully overridden plan needs no calibration.
+        bool calibrate = overridden.numThreads == 0 || overridden.kernel == Kernel::automatic;
+        auto chosen = plan(numPages, numEdges, overridden, calibrate ? MachineCalibration::get() : MachineCalibration { 1, 0, 0, 0, 0, { 1 } });
+
+        std::string message = "AutoPageRankComputer chose " + makeEngine(chosen)->getName() + ": " + chosen.reason;
+        if (this->log)
+            this->log(message);
+        static bool const logToStderr = std::getenv("PAGERANK_AUTO_LOG") != nullptr;
+        if (logToStderr)
+            std::cerr << message << std::endl;
+        return chosen;
+    }
+
+    static std::unique_ptr<PageRankComputer> makeEngine(AutoPlan const& chosen)
+    {
+        if (chosen.numThreads == 1 && not chosen.compressEdges)
+            return std::unique_ptr<PageRankComputer>(new SingleThreadedPageRankComputer {});
+        return std::unique_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { chosen.numThreads, chosen.compressEdges });
+    }
+
+    // Links leaving the network included, close enough for planning.
+    static uint64_t countLinks(Network const& network)
+    {
+        uint64_t numLinks = 0;
+        for (auto const& page : network.getPages())
+            numLinks += page.getLinks().size();
+        return numLinks;
+    }
+};
+
+#endif /* SRC_AUTOPAGERANKCOMPUTER_HPP_ */
@@ -0,0 +1,133 @@
+#ifndef SRC_BLOCKPOWERITERATION_HPP_
+#define SRC_BLOCKPOWERITERATION_HPP_
+
+#include <cmath>
+#include <vector>
+
+#include "immutable/pageIdAndRank.hpp"
+#include "parallelUtils.hpp"
+#include "preparedGraph.hpp"
+
+// Parameters of one rank vector of a block.
+struct PageRankParameters {
+    double alpha;
+    double tolerance;
+};
+
+// Power iteration over a block of rank vectors at once. Column q has its own
+// parameters and teleport vector, teleport[v * numColumns + q] being the jump
+// probability to page v; dangling weight jumps the same way. Ranks of all
+// columns are interleaved per page, so every in-link is read once per
+// iteration and serves the whole block.
+class BlockPowerIteration {
+public:
+    // Ranks interleaved like `teleport`, empty when some column did not
+    // converge in `iterations`. Columns start from their teleport vector.
+    static std::vector<PageRank> run(PreparedGraph const& graph, uint32_t numThreads, std::vector<PageRankParameters> const& parameters, std::vector<double> const& teleport, uint32_t iterations)
+    {
+        size_t numColumns = parameters.size();
+        size_t networkSize = graph.getSize();
+        ASSERT(teleport.size() == networkSize * numColumns, "Invalid teleport size=" << teleport.size());
+
+        // Two rank blocks, iteration i reads block i % 2 and writes the other.
+        std::vector<PageRank> pageRanks[2] = { teleport, std::vector<PageRank>(networkSize * numColumns) };
+
+        auto const& numLinks = graph.getNumLinks();
+        auto const& danglingNodes = graph.getDanglingNodes();
+        auto const& offsets = graph.getEdges().getOffsets();
+        auto const& sources = graph.getEdges().getSources();
+
+        // Partial values of each thread, numColumns per thread.
+        std::vector<double> dangleSums(numThreads * numColumns), differences(numThreads * numColumns);
+        Barrier barrier { numThreads };
+        bool converged = false;
+        uint32_t resultBlock = 0;
+
+        runInParallel(numThreads, [&](uint32_t thread) {
+            PageIndex pagesBegin = graph.getEdges().balancedSegmentBegin(numThreads, thread);
+            PageIndex pagesEnd = graph.getEdges().balancedSegmentBegin(numThreads, thread + 1);
+            std::vector<double> jump(numColumns), rank(numColumns);
+            double* myDangleSums = &dangleSums[thread * numColumns];
+            double* myDifferences = &differences[thread * numColumns];
+
+            for (uint32_t i = 0; i < iterations; ++i) {
+                auto const& previous = pageRanks[i % 2];
+                auto& current = pageRanks[(i + 1) % 2];
+
+                std::fill(myDangleSums, myDangleSums + numColumns, 0.0);
+                auto danglingEnd = segmentEnd(danglingNodes.size(), numThreads, thread);
+                for (auto d = segmentBegin(danglingNodes.size(), numThreads, thread); d < danglingEnd; ++d)
+                    for (size_t q = 0; q < numColumns; ++q)
+                        myDangleSums[q] += previous[danglingNodes[d] * numColumns + q];
+
+                barrier.await();
+
+                // Weight jumping by teleport or from dangling pages, per column.
+                for (size_t q = 0; q < numColumns; ++q) {
+                    double dangleSum = 0;
+                    for (uint32_t t = 0; t < numThreads; ++t)
+                        dangleSum += dangleSums[t * numColumns + q];
+                    jump[q] = parameters[q].alpha * dangleSum + 1.0 - parameters[q].alpha;
+                }
+
+                // One pass over the in-links of every page serves all columns.
+                std::fill(myDifferences, myDifferences + numColumns, 0.0);
+                for (PageIndex v = pagesBegin; v < pagesEnd; ++v) {
+                    std::fill(rank.begin(), rank.end(), 0.0);
+                    for (uint64_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+                        double weight = 1.0 / numLinks[sources[e]];
+                        double const* source = &previous[sources[e] * numColumns];
+                        for (size_t q = 0; q < numColumns; ++q)
+                            rank[q] += weight * source[q];
+                    }
+                    for (size_t q = 0; q < numColumns; ++q) {
+                        size_t at = v * numColumns + q;
+                        rank[q] = parameters[q].alpha * rank[q] + jump[q] * teleport[at];
+                        myDifferences[q] += std::abs(previous[at] - rank[q]);
+                        current[at] = rank[q];
+                    }
+                }
+
+                barrier.await();
+
+                // Every thread reaches the same decision, no master needed.
+                bool allConverged = true;
+                for (size_t q = 0; q < numColumns; ++q) {
+                    double difference = 0;
+                    for (uint32_t t = 0; t < numThreads; ++t)
+                        difference += differences[t * numColumns + q];
+                    allConverged = allConverged && difference < parameters[q].tolerance;
+                }
+                if (allConverged) {
+                    if (thread == 0) {
+                        converged = true;
+                        resultBlock = (i + 1) % 2;
+                    }
+                    return;
+                }
+            }
+        });
+
+        if (not converged)
+            return {};
+        return std::move(pageRanks[resultBlock]);
+    }
+
+    // Uniform teleport vectors for a block of numColumns columns.
+    static std::vector<double> uniformTeleport(size_t networkSize, size_t numColumns)
+    {
+        return std::vector<double>(networkSize * numColumns, 1.0 / networkSize);
+    }
+
+    // Column q of `ranks` as a full result.
+    static std::vector<PageIdAndRank> materialize(PreparedGraph const& graph, std::vector<PageRank> const& ranks, size_t numColumns, size_t q)
+    {
+        std::vector<PageIdAndRank> result;
+        result.reserve(graph.getSize());
+        for (PageIndex v = 0; v < graph.getSize(); ++v)
+            result.push_back(PageIdAndRank(graph.getId(v), ranks[v * numColumns + q]));
+        return result;
+    }
+};
+
+#endif /* SRC_BLOCKPOWERITERATION_HPP_ */
@@ -0,0 +1,253 @@
+#ifndef SRC_CHECKPOINT_HPP_
+#define SRC_CHECKPOINT_HPP_
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "immutable/common.hpp"
+#include "immutable/pageIdAndRank.hpp"
+
+// Where and how often a run saves its state, everyIterations == 0 disables
+// checkpoints.
+struct CheckpointConfig {
+    std::string path;
+    uint32_t everyIterations;
+};
+
+// State of a run after `iteration` iterations. On disk it is a fixed header
+// (magic, version, graph size, number of edges and fingerprint, alpha,
+// iteration) followed by the raw ranks.
+class Checkpoint {
+public:
+    // Header fields identifying the run, a checkpoint only resumes a run
+    // with the same ones.
+    struct Key {
+        uint64_t networkSize;
+        uint64_t numEdges;
+        // PreparedGraph::getFingerprint().
+        uint64_t fingerprint;
+        double alpha;
+    };
+
+    uint32_t iteration;
+    std::vector<PageRank> pageRanks;
+
+    // Replaces `path` as a whole, a crash leaves the previous checkpoint.
+    // False when it cannot be written (missing directory, full disk, failed
+    // rename), the previous checkpoint then stays too and `error` says why.
+    static bool write(std::string const& path, Key const& key, uint32_t iteration, std::vector<PageRank> const& pageRanks,
+        std::string* error = nullptr)
+    {
+        std::string temporaryPath = path + ".tmp";
+        FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+        if (file == nullptr)
+            return fail(error, "Cannot create checkpoint=" + temporaryPath);
+
+        Header header = makeHeader(key, iteration);
+        bool written = std::fwrite(&header, sizeof(header), 1, file) == 1
+            && std::fwrite(pageRanks.data(), sizeof(PageRank), pageRanks.size(), file) == pageRanks.size();
+        if (std::fclose(file) != 0 || not written) {
+            fail(error, "Cannot write checkpoint=" + temporaryPath);
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+        if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            fail(error, "Cannot replace checkpoint=" + path);
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // False when there is no checkpoint of this run at `path`: none at all,
+    // one of another graph, alpha or version, or a truncated one. The run
+    // then starts over and its first checkpoint replaces the file.
+    static bool read(std::string const& path, Key const& key, Checkpoint& checkpoint)
+    {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr)
+            return false;
+
+        Header header;
+        bool valid = std::fread(&header, sizeof(header), 1, file) == 1;
+        if (valid) {
+            Header expected = makeHeader(key, header.iteration);
+            valid = std::memcmp(&header, &expected, sizeof(header)) == 0;
+        }
+        if (valid) {
+            checkpoint.pageRanks.resize(key.networkSize);
+            valid = std::fread(checkpoint.pageRanks.data(), sizeof(PageRank), key.networkSize, file) == key.networkSize;
+        }
+        std::fclose(file);
+        if (not valid) {
+            checkpoint.pageRanks.clear();
+            return false;
+        }
+        checkpoint.iteration = header.iteration;
+        return true;
+    }
+
+private:
+    static constexpr uint32_t version = 2;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t networkSize;
+        uint64_t numEdges;
+        uint64_t fingerprint;
+        double alpha;
+        uint32_t iteration;
+        uint32_t padding;
+    };
+
+    // Always false, with errno described in `error`.
+    static bool fail(std::string* error, std::string const& message)
+    {
+        if (error != nullptr)
+            *error = message + ": " + std::strerror(errno);
+        return false;
+    }
+
+    static Header makeHeader(Key const& key, uint32_t iteration)
+    {
+        Header header;
+        std::memcpy(header.magic, "PRCK", 4);
+        header.version = version;
+        header.networkSize = key.networkSize;
+        header.numEdges = key.numEdges;
+        header.fingerprint = key.fingerprint;
+        header.alpha = key.alpha;
+        header.iteration = iteration;
+        header.padding = 0;
+        return header;
+    }
+};
+
+// Writes checkpoints on a thread of its own. offer() only copies the ranks
+// and returns; when the previous checkpoint is still being written the new
+// one is skipped instead of waiting for the disk. A checkpoint that cannot
+// be written is counted as failed, the first failure logged to stderr, and
+// the run goes on.
+class CheckpointWriter {
+public:
+    CheckpointWriter(std::string const& pathArg, Checkpoint::Key const& keyArg)
+        : path(pathArg)
+        , key(keyArg)
+        , pending(false)
+        , stopping(false)
+        , iteration(0)
+        , pageRanks()
+        , numWritten(0)
+        , numSkipped(0)
+        , numFailed(0)
+        , lastError()
+        , writer([this] { this->writeLoop(); })
+    {
+    }
+
+    CheckpointWriter(CheckpointWriter const&) = delete;
+    CheckpointWriter& operator=(CheckpointWriter const&) = delete;
+
+    // Waits for the checkpoint in progress.
+    ~CheckpointWriter()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mut);
+            stopping = true;
+        }
+        cond.notify_all();
+        writer.join();
+    }
+
+    // True when the ranks after `iterationArg` iterations will be written.
+    bool offer(uint32_t iterationArg, std::vector<PageRank> const& pageRanksArg)
+    {
+        std::unique_lock<std::mutex> lock(mut);
+        if (pending) {
+            ++numSkipped;
+            return false;
+        }
+        iteration = iterationArg;
+        pageRanks = pageRanksArg;
+        pending = true;
+        cond.notify_all();
+        return true;
+    }
+
+    // Checkpoints written, skipped and failed so far.
+    uint32_t getNumWritten()
+    {
+        std::unique_lock<std::mutex> lock(mut);
+        return numWritten;
+    }
+
+    uint32_t getNumSkipped()
+    {
+        std::unique_lock<std::mutex> lock(mut);
+        return numSkipped;
+    }
+
+    uint32_t getNumFailed()
+    {
+        std::unique_lock<std::mutex> lock(mut);
+        return numFailed;
+    }
+
+    // Why the last checkpoint failed, empty when none did.
+    std::string getLastError()
+    {
+        std::unique_lock<std::mutex> lock(mut);
+        return lastError;
+    }
+
+private:
+    std::string path;
+    Checkpoint::Key key;
+
+    std::mutex mut;
+    std::condition_variable cond;
+    bool pending;
+    bool stopping;
+    // Only touched by the writer while pending.
+    uint32_t iteration;
+    std::vector<PageRank> pageRanks;
+    uint32_t numWritten;
+    uint32_t numSkipped;
+    uint32_t numFailed;
+    std::string lastError;
+
+    std::thread writer;
+
+    void writeLoop()
+    {
+        std::unique_lock<std::mutex> lock(mut);
+        while (true) {
+            cond.wait(lock, [this] { return pending || stopping; });
+            if (not pending)
+                return;
+
+            lock.unlock();
+            std::string error;
+            bool written = Checkpoint::write(path, key, iteration, pageRanks, &error);
+            lock.lock();
+            pending = false;
+            if (written) {
+                ++numWritten;
+                continue;
+            }
+            if (numFailed++ == 0)
+                std::cerr << error << std::endl;
+            lastError = error;
+        }
+    }
+};
+
+#endif /* SRC_CHECKPOINT_HPP_ */
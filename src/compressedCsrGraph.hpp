@@ -0,0 +1,158 @@
+#ifndef SRC_COMPRESSEDCSRGRAPH_HPP_
+#define SRC_COMPRESSEDCSRGRAPH_HPP_
+
+#include <algorithm>
+#include <vector>
+
+#include "csrGraph.hpp"
+#include "pageIndex.hpp"
+#include "parallelUtils.hpp"
+
+// CsrGraph with every row sorted and stored as varint encoded gaps (7 bits
+// per byte, low groups first). The first source of row v is stored as the
+// zigzag encoded difference to v, the next ones as differences to the
+// previous source, so rows of pages linking to nearby pages take a byte
+// per in-link instead of four. Row v is bytes[offsets[v]], ...,
+// bytes[offsets[v + 1] - 1], rows can only be read whole and in order.
+class CompressedCsrGraph {
+public:
+    CompressedCsrGraph(CsrGraph const& graph, uint32_t numThreads)
+        : offsets(graph.getSize() + 1, 0)
+        , bytes()
+    {
+        auto const& graphOffsets = graph.getOffsets();
+        auto const& sources = graph.getSources();
+
+        // Every thread encodes a range of rows into its own buffer, the
+        // buffers are then concatenated.
+        std::vector<std::vector<uint8_t>> encoded(numThreads);
+        runInParallel(numThreads, [&](uint32_t thread) {
+            std::vector<PageIndex> unsortedRow;
+            auto end = segmentEnd(graph.getSize(), numThreads, thread);
+            for (auto v = segmentBegin(graph.getSize(), numThreads, thread); v < end; ++v) {
+                PageIndex const* row = sources.data() + graphOffsets[v];
+                size_t rowSize = graphOffsets[v + 1] - graphOffsets[v];
+                if (not std::is_sorted(row, row + rowSize)) {
+                    unsortedRow.assign(row, row + rowSize);
+                    sortRuns(unsortedRow);
+                    row = unsortedRow.data();
+                }
+                for (size_t i = 0; i < rowSize; ++i) {
+                    if (i == 0)
+                        putVarint(encoded[thread], zigzag(static_cast<int64_t>(row[0]) - static_cast<int64_t>(v)));
+                    else
+                        putVarint(encoded[thread], row[i] - row[i - 1]);
+                }
+                // Relative to the thread buffer until the concatenation.
+                offsets[v + 1] = encoded[thread].size();
+            }
+        });
+
+        std::vector<uint64_t> bufferBegin(numThreads + 1, 0);
+        for (uint32_t t = 0; t < numThreads; ++t)
+            bufferBegin[t + 1] = bufferBegin[t] + encoded[t].size();
+        bytes.resize(bufferBegin[numThreads]);
+
+        runInParallel(numThreads, [&](uint32_t thread) {
+            std::copy(encoded[thread].begin(), encoded[thread].end(), bytes.begin() + bufferBegin[thread]);
+            std::vector<uint8_t>().swap(encoded[thread]);
+            auto end = segmentEnd(graph.getSize(), numThreads, thread);
+            for (auto v = segmentBegin(graph.getSize(), numThreads, thread); v < end; ++v)
+                offsets[v + 1] += bufferBegin[thread];
+        });
+    }
+
+    size_t getSize() const
+    {
+        return this->offsets.size() - 1;
+    }
+
+    // Like CsrGraph::balancedSegmentBegin, costing rows by their bytes.
+    PageIndex balancedSegmentBegin(uint32_t numParts, uint32_t index) const
+    {
+        return balancedSplit(this->offsets, numParts, index);
+    }
+
+    // Calls func(source) for every page linking to v, in ascending order.
+    template <typename Func>
+    void forEachSource(PageIndex v, Func const& func) const
+    {
+        uint8_t const* at = this->bytes.data() + this->offsets[v];
+        uint8_t const* end = this->bytes.data() + this->offsets[v + 1];
+        if (at == end)
+            return;
+
+        uint64_t first = getVarint(at);
+        // Undo the zigzag encoding of the difference to v.
+        PageIndex source = static_cast<PageIndex>(v + static_cast<int64_t>((first >> 1) ^ -(first & 1)));
+        func(source);
+        while (at != end) {
+            source += static_cast<PageIndex>(getVarint(at));
+            func(source);
+        }
+    }
+
+    size_t getSizeInBytes() const
+    {
+        return this->offsets.size() * sizeof(uint64_t) + this->bytes.size();
+    }
+
+private:
+    std::vector<uint64_t> offsets;
+    std::vector<uint8_t> bytes;
+
+    // Rows of CsrGraphBuilder are a few ascending runs, one per buffer, so
+    // merging the runs pairwise beats a full sort.
+    static void sortRuns(std::vector<PageIndex>& row)
+    {
+        std::vector<size_t> runBegins { 0 };
+        for (size_t i = 1; i < row.size(); ++i)
+            if (row[i] < row[i - 1])
+                runBegins.push_back(i);
+        runBegins.push_back(row.size());
+
+        while (runBegins.size() > 2) {
+            std::vector<size_t> merged;
+            for (size_t r = 0; r + 2 < runBegins.size(); r += 2) {
+                std::inplace_merge(row.begin() + runBegins[r], row.begin() + runBegins[r + 1], row.begin() + runBegins[r + 2]);
+                merged.push_back(runBegins[r]);
+            }
+            if (runBegins.size() % 2 == 0)
+                merged.push_back(runBegins[runBegins.size() - 2]);
+            merged.push_back(row.size());
+            runBegins.swap(merged);
+        }
+    }
+
+    static uint64_t zigzag(int64_t value)
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    static void putVarint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static uint64_t getVarint(uint8_t const*& at)
+    {
+        // Most gaps of local graphs fit in one byte.
+        uint64_t value = *at++;
+        if (value < 0x80)
+            return value;
+
+        value &= 0x7f;
+        for (uint32_t shift = 7;; shift += 7) {
+            uint64_t byte = *at++;
+            value |= (byte & 0x7f) << shift;
+            if (byte < 0x80)
+                return value;
+        }
+    }
+};
+
+#endif /* SRC_COMPRESSEDCSRGRAPH_HPP_ */
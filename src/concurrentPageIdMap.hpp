@@ -0,0 +1,117 @@
+#ifndef SRC_CONCURRENTPAGEIDMAP_HPP_
+#define SRC_CONCURRENTPAGEIDMAP_HPP_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "immutable/common.hpp"
+#include "immutable/pageId.hpp"
+#include "pageIndex.hpp"
+
+// Fixed capacity PageId -> PageIndex map, filled and queried by many threads
+// at once. Page i registers its id with insert(i, id).
+//
+// Open addressing with linear probing over 64 bit slots, each packing a 32 bit
+// hash tag with index + 1 (0 marks an empty slot). Inserts claim a slot with a
+// single CAS, so they are lock-free. Lookups only load slots and give up at the
+// first empty one, the table is never more than half full, so they are
+// wait-free. Entries are never removed.
+class ConcurrentPageIdMap {
+public:
+    ConcurrentPageIdMap(size_t numKeys)
+        : keys(numKeys, PageId(""))
+        , mask(capacityFor(numKeys) - 1)
+        , slots(new std::atomic<uint64_t>[capacityFor(numKeys)])
+    {
+        for (size_t i = 0; i <= this->mask; ++i)
+            this->slots[i].store(0, std::memory_order_relaxed);
+    }
+
+    ConcurrentPageIdMap(ConcurrentPageIdMap const&) = delete;
+    ConcurrentPageIdMap& operator=(ConcurrentPageIdMap const&) = delete;
+
+    // Publishes `pageId` under `index`. Every index is inserted by one thread
+    // only. Returns `index`, or the index registered earlier for an equal id.
+    PageIndex insert(PageIndex index, PageId const& pageId)
+    {
+        ASSERT(index < this->keys.size(), "Index out of range=" << index);
+        // Written before the CAS which publishes it.
+        this->keys[index] = pageId;
+
+        std::size_t hash = PageIdHash {}(pageId);
+        uint64_t mine = pack(hash, index);
+        for (std::size_t pos = hash & this->mask;; pos = (pos + 1) & this->mask) {
+            uint64_t current = this->slots[pos].load(std::memory_order_acquire);
+            while (current == 0) {
+                if (this->slots[pos].compare_exchange_weak(current, mine, std::memory_order_acq_rel, std::memory_order_acquire))
+                    return index;
+            }
+            if (sameTag(current, hash) && this->keys[unpack(current)] == pageId)
+                return unpack(current);
+        }
+    }
+
+    // Safe to call concurrently with insert(), ids inserted so far are visible.
+    bool find(PageId const& pageId, PageIndex& index) const
+    {
+        std::size_t hash = PageIdHash {}(pageId);
+        for (std::size_t pos = hash & this->mask;; pos = (pos + 1) & this->mask) {
+            uint64_t current = this->slots[pos].load(std::memory_order_acquire);
+            if (current == 0)
+                return false;
+            if (sameTag(current, hash) && this->keys[unpack(current)] == pageId) {
+                index = unpack(current);
+                return true;
+            }
+        }
+    }
+
+    // Only valid once insert(index, ...) is visible to the caller.
+    PageId const& getId(PageIndex index) const
+    {
+        return this->keys[index];
+    }
+
+    size_t size() const
+    {
+        return this->keys.size();
+    }
+
+private:
+    std::vector<PageId> keys;
+    std::size_t mask;
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;
+
+    // Power of two keeping the load factor at most 1/2.
+    static std::size_t capacityFor(size_t numKeys)
+    {
+        std::size_t capacity = 2;
+        while (capacity < 2 * numKeys)
+            capacity *= 2;
+        return capacity;
+    }
+
+    static uint64_t tagOf(std::size_t hash)
+    {
+        // Low bits pick the slot, high bits make a better filter.
+        return static_cast<uint64_t>(hash) >> 32 ^ (static_cast<uint64_t>(hash) & 0xffffffffu);
+    }
+
+    static uint64_t pack(std::size_t hash, PageIndex index)
+    {
+        return tagOf(hash) << 32 | (static_cast<uint64_t>(index) + 1);
+    }
+
+    static PageIndex unpack(uint64_t slot)
+    {
+        return static_cast<PageIndex>((slot & 0xffffffffu) - 1);
+    }
+
+    static bool sameTag(uint64_t slot, std::size_t hash)
+    {
+        return slot >> 32 == tagOf(hash);
+    }
+};
+
+#endif /* SRC_CONCURRENTPAGEIDMAP_HPP_ */
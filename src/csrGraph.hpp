@@ -0,0 +1,265 @@
+#ifndef SRC_CSRGRAPH_HPP_
+#define SRC_CSRGRAPH_HPP_
+
+#include <memory>
+#include <vector>
+
+#include "immutable/common.hpp"
+#include "pageIndex.hpp"
+#include "parallelUtils.hpp"
+
+// First row of the index-th out of numParts contiguous row ranges of similar
+// cost, a row costing one unit plus offsets[v + 1] - offsets[v].
+inline PageIndex balancedSplit(std::vector<uint64_t> const& offsets, uint32_t numParts, uint32_t index)
+{
+    uint64_t size = offsets.size() - 1;
+    uint64_t total = offsets.back() + size;
+    uint64_t goal = total / numParts * index + std::min<uint64_t>(index, total % numParts);
+
+    // offsets[v] + v is strictly increasing, so binary search for the goal.
+    size_t low = 0, high = size;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (offsets[mid] + mid < goal)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// In-link adjacency in compressed sparse row form. The pages linking to page v
+// are sources[offsets[v]], ..., sources[offsets[v + 1] - 1].
+class CsrGraph {
+public:
+    CsrGraph()
+        : offsets(1, 0)
+        , sources()
+    {
+    }
+
+    // Rows given as they are, offsetsArg.size() - 1 pages.
+    CsrGraph(std::vector<uint64_t> offsetsArg, std::vector<PageIndex> sourcesArg)
+        : offsets(std::move(offsetsArg))
+        , sources(std::move(sourcesArg))
+    {
+        ASSERT(not this->offsets.empty() && this->offsets.back() == this->sources.size(),
+            "Inconsistent rows, offsets=" << this->offsets.size() << ", sources=" << this->sources.size());
+    }
+
+    size_t getSize() const
+    {
+        return this->offsets.size() - 1;
+    }
+
+    uint64_t getNumEdges() const
+    {
+        return this->sources.size();
+    }
+
+    std::vector<uint64_t> const& getOffsets() const
+    {
+        return this->offsets;
+    }
+
+    std::vector<PageIndex> const& getSources() const
+    {
+        return this->sources;
+    }
+
+    // Splits pages into numParts contiguous ranges of similar cost, counting
+    // one unit per page and one per in-link. Returns the first page of range index.
+    PageIndex balancedSegmentBegin(uint32_t numParts, uint32_t index) const
+    {
+        return balancedSplit(this->offsets, numParts, index);
+    }
+
+    // Calls func(source) for every page linking to v.
+    template <typename Func>
+    void forEachSource(PageIndex v, Func const& func) const
+    {
+        for (uint64_t e = this->offsets[v]; e < this->offsets[v + 1]; ++e)
+            func(this->sources[e]);
+    }
+
+    size_t getSizeInBytes() const
+    {
+        return this->offsets.size() * sizeof(uint64_t) + this->sources.size() * sizeof(PageIndex);
+    }
+
+    // The same graph with every edge reversed, so rows list out-links.
+    CsrGraph transposed(uint32_t numThreads) const;
+
+    // The subgraph induced by `vertices`, in ascending order, vertices[i]
+    // becoming vertex i. numbers[v] is the new number of every vertex of the
+    // subgraph and vertices.size() for the others. Rows keep their order.
+    CsrGraph induced(std::vector<PageIndex> const& vertices, std::vector<PageIndex> const& numbers, uint32_t numThreads) const;
+
+private:
+    std::vector<uint64_t> offsets;
+    std::vector<PageIndex> sources;
+
+    friend class CsrGraphBuilder;
+};
+
+// Builds a CsrGraph from edges discovered by several threads at once.
+//
+// Every producing thread appends to its own buffer. build() then runs a two
+// pass radix sort by destination: edges are first scattered into one bucket
+// per thread (a contiguous range of destinations), and each thread counting
+// sorts its own bucket and scatters it into the final array. When buffer i
+// holds edges of sources smaller than those of buffer i + 1 and each buffer is
+// filled in ascending source order, every neighbour list comes out sorted.
+class CsrGraphBuilder {
+public:
+    CsrGraphBuilder(size_t numVerticesArg, uint32_t numThreadsArg)
+        : numVertices(numVerticesArg)
+        , numThreads(numThreadsArg)
+        , buffers(numThreadsArg)
+    {
+        ASSERT(numThreadsArg > 0, "CsrGraphBuilder needs at least one thread");
+    }
+
+    // Safe to call concurrently for distinct `thread` values.
+    void addEdge(uint32_t thread, PageIndex from, PageIndex to)
+    {
+        this->buffers[thread].push_back({ from, to });
+    }
+
+    CsrGraph build()
+    {
+        CsrGraph graph;
+        graph.offsets.resize(this->numVertices + 1, 0);
+        if (this->numVertices == 0)
+            return graph;
+
+        uint32_t numBuckets = this->numThreads;
+        size_t bucketWidth = (this->numVertices + numBuckets - 1) / numBuckets;
+
+        // First pass: histogram of destination buckets for every buffer.
+        std::vector<std::vector<uint64_t>> cursors(this->numThreads, std::vector<uint64_t>(numBuckets, 0));
+        runInParallel(this->numThreads, [&](uint32_t t) {
+            for (auto const& edge : this->buffers[t])
+                ++cursors[t][edge.to / bucketWidth];
+        });
+
+        // Turn the histograms into write cursors, bucket major, buffer minor.
+        std::vector<uint64_t> bucketBegin(numBuckets + 1, 0);
+        uint64_t position = 0;
+        for (uint32_t b = 0; b < numBuckets; ++b) {
+            bucketBegin[b] = position;
+            for (uint32_t t = 0; t < this->numThreads; ++t) {
+                auto count = cursors[t][b];
+                cursors[t][b] = position;
+                position += count;
+            }
+        }
+        bucketBegin[numBuckets] = position;
+
+        std::unique_ptr<Edge[]> bucketed(new Edge[position]);
+        runInParallel(this->numThreads, [&](uint32_t t) {
+            for (auto const& edge : this->buffers[t])
+                bucketed[cursors[t][edge.to / bucketWidth]++] = edge;
+            std::vector<Edge>().swap(this->buffers[t]);
+        });
+
+        // Second pass: counting sort inside every bucket. Bucket b owns
+        // offsets (low, high] and the matching slice of sources.
+        graph.sources.resize(position);
+        runInParallel(numBuckets, [&](uint32_t b) {
+            size_t low = std::min(this->numVertices, b * bucketWidth);
+            size_t high = std::min(this->numVertices, low + bucketWidth);
+
+            std::vector<uint64_t> next(high - low, 0);
+            for (uint64_t i = bucketBegin[b]; i < bucketBegin[b + 1]; ++i)
+                ++next[bucketed[i].to - low];
+
+            uint64_t offset = bucketBegin[b];
+            for (size_t v = low; v < high; ++v) {
+                auto count = next[v - low];
+                next[v - low] = offset;
+                offset += count;
+                graph.offsets[v + 1] = offset;
+            }
+
+            for (uint64_t i = bucketBegin[b]; i < bucketBegin[b + 1]; ++i)
+                graph.sources[next[bucketed[i].to - low]++] = bucketed[i].from;
+        });
+
+        return graph;
+    }
+
+private:
+    struct Edge {
+        PageIndex from;
+        PageIndex to;
+    };
+
+    size_t numVertices;
+    uint32_t numThreads;
+    std::vector<std::vector<Edge>> buffers;
+};
+
+inline CsrGraph CsrGraph::transposed(uint32_t numThreads) const
+{
+    // Several threads bucket the edges of their own rows, each edge once.
+    if (numThreads > 1) {
+        CsrGraphBuilder builder(this->getSize(), numThreads);
+        runInParallel(numThreads, [&](uint32_t thread) {
+            auto end = segmentEnd(this->getSize(), numThreads, thread);
+            for (auto v = segmentBegin(this->getSize(), numThreads, thread); v < end; ++v)
+                for (uint64_t e = this->offsets[v]; e < this->offsets[v + 1]; ++e)
+                    builder.addEdge(thread, v, this->sources[e]);
+        });
+        return builder.build();
+    }
+
+    // One thread counting sorts by source without the buffers of the
+    // builder, rows come out sorted the same.
+    size_t size = this->getSize();
+    CsrGraph graph;
+    graph.offsets.resize(size + 1, 0);
+    for (auto source : this->sources)
+        ++graph.offsets[source + 1];
+    for (size_t v = 0; v < size; ++v)
+        graph.offsets[v + 1] += graph.offsets[v];
+
+    graph.sources.resize(this->sources.size());
+    std::vector<uint64_t> next(graph.offsets.begin(), graph.offsets.end() - 1);
+    for (PageIndex v = 0; v < size; ++v) {
+        for (uint64_t e = this->offsets[v]; e < this->offsets[v + 1]; ++e)
+            graph.sources[next[this->sources[e]]++] = v;
+    }
+    return graph;
+}
+
+inline CsrGraph CsrGraph::induced(std::vector<PageIndex> const& vertices, std::vector<PageIndex> const& numbers, uint32_t numThreads) const
+{
+    size_t size = vertices.size();
+    CsrGraph graph;
+    graph.offsets.resize(size + 1, 0);
+    runInParallel(numThreads, [&](uint32_t thread) {
+        auto end = segmentEnd(size, numThreads, thread);
+        for (auto i = segmentBegin(size, numThreads, thread); i < end; ++i) {
+            for (uint64_t e = this->offsets[vertices[i]]; e < this->offsets[vertices[i] + 1]; ++e)
+                graph.offsets[i + 1] += numbers[this->sources[e]] < size;
+        }
+    });
+    for (size_t i = 0; i < size; ++i)
+        graph.offsets[i + 1] += graph.offsets[i];
+
+    graph.sources.resize(graph.offsets[size]);
+    runInParallel(numThreads, [&](uint32_t thread) {
+        auto end = segmentEnd(size, numThreads, thread);
+        for (auto i = segmentBegin(size, numThreads, thread); i < end; ++i) {
+            uint64_t position = graph.offsets[i];
+            for (uint64_t e = this->offsets[vertices[i]]; e < this->offsets[vertices[i] + 1]; ++e) {
+                if (numbers[this->sources[e]] < size)
+                    graph.sources[position++] = numbers[this->sources[e]];
+            }
+        }
+    });
+    return graph;
+}
+
+#endif /* SRC_CSRGRAPH_HPP_ */
@@ -0,0 +1,246 @@
+#ifndef SRC_DISTRIBUTEDPAGERANKCOMPUTER_HPP_
+#define SRC_DISTRIBUTEDPAGERANKCOMPUTER_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+#include "immutable/pageRankComputer.hpp"
+#include "preparedGraph.hpp"
+#include "processGroup.hpp"
+
+// PageRank on numProcesses local processes which share nothing but messages.
+// Every process owns the pages MultiThreadedPageRankComputer gives to the
+// thread of the same number and pulls their ranks from its copy of the
+// previous ranks. Each iteration a process sends every peer, in one batch,
+// the ranks of its boundary pages (the ones the peer reads) which changed,
+// as varint encoded index gaps with the raw values, so the peer copies stay
+// exact. Partial sums are combined in process order, so the results are
+// bitwise the ones of MultiThreadedPageRankComputer with as many threads.
+//
+// Process 0 is the caller, the others are forked for every computation and
+// see the prepared graph without copying it.
+class DistributedPageRankComputer : public PageRankComputer {
+public:
+    DistributedPageRankComputer(uint32_t numProcessesArg)
+        : numProcesses(numProcessesArg) {};
+
+    std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha, uint32_t iterations, double tolerance) const
+    {
+        PreparedGraph graph(network, numProcesses);
+        return computeForGraph(graph, alpha, iterations, tolerance);
+    }
+
+    std::vector<PageIdAndRank> computeTopK(Network const& network, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        PreparedGraph graph(network, numProcesses);
+        return computeTopKForGraph(graph, alpha, iterations, tolerance, k);
+    }
+
+    std::vector<PageIdAndRank> computeForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance) const
+    {
+        return graph.toResult(computeRanks(graph, alpha, iterations, tolerance));
+    }
+
+    std::vector<PageIdAndRank> computeTopKForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        return graph.toTopKResult(computeRanks(graph, alpha, iterations, tolerance), k, numProcesses);
+    }
+
+    std::string getName() const
+    {
+        return "DistributedPageRankComputer[" + std::to_string(this->numProcesses) + " processes]";
+    }
+
+private:
+    uint32_t numProcesses;
+
+    // Ranks indexed by the page indices of `graph`, gathered in process 0.
+    std::vector<PageRank> computeRanks(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance) const
+    {
+        std::vector<PageRank> result;
+        ProcessGroup::run(numProcesses, [&](ProcessGroup& group) {
+            Partition partition(graph, group);
+            std::vector<PageRank> pageRanks = iterate(graph, group, partition, alpha, iterations, tolerance);
+
+            // Every process sends the ranks of its pages to process 0.
+            std::vector<std::string> outgoing(group.getSize());
+            if (group.getRank() != 0) {
+                MessageWriter message;
+                for (PageIndex v = partition.pagesBegin(group.getRank()); v < partition.pagesEnd(group.getRank()); ++v)
+                    message.putDouble(pageRanks[v]);
+                outgoing[0] = std::move(message.getData());
+            }
+            auto incoming = group.exchange(outgoing);
+            if (group.getRank() != 0)
+                return;
+
+            for (uint32_t q = 1; q < group.getSize(); ++q) {
+                MessageReader message(incoming[q]);
+                for (PageIndex v = partition.pagesBegin(q); v < partition.pagesEnd(q); ++v)
+                    pageRanks[v] = message.getDouble();
+            }
+            result = std::move(pageRanks);
+        });
+        return result;
+    }
+
+    // Pages and dangling pages of every process, and which pages of this
+    // process each peer reads.
+    class Partition {
+    public:
+        Partition(PreparedGraph const& graph, ProcessGroup const& group)
+            : firstPages(group.getSize() + 1)
+            , boundaries(group.getSize())
+        {
+            auto const& edges = graph.getEdges();
+            auto const& danglingNodes = graph.getDanglingNodes();
+            for (uint32_t q = 0; q <= group.getSize(); ++q)
+                firstPages[q] = edges.balancedSegmentBegin(group.getSize(), q);
+
+            uint32_t me = group.getRank();
+            std::vector<bool> read(graph.getSize(), false);
+            for (uint32_t q = 0; q < group.getSize(); ++q) {
+                if (q == me)
+                    continue;
+                auto markIfMine = [&](PageIndex v) {
+                    if (v >= this->pagesBegin(me) && v < this->pagesEnd(me))
+                        read[v] = true;
+                };
+                for (uint64_t e = edges.getOffsets()[this->pagesBegin(q)]; e < edges.getOffsets()[this->pagesEnd(q)]; ++e)
+                    markIfMine(edges.getSources()[e]);
+                auto danglingEnd = segmentEnd(danglingNodes.size(), group.getSize(), q);
+                for (auto d = segmentBegin(danglingNodes.size(), group.getSize(), q); d < danglingEnd; ++d)
+                    markIfMine(danglingNodes[d]);
+
+                for (PageIndex v = this->pagesBegin(me); v < this->pagesEnd(me); ++v) {
+                    if (read[v]) {
+                        boundaries[q].push_back(v);
+                        read[v] = false;
+                    }
+                }
+            }
+        }
+
+        PageIndex pagesBegin(uint32_t process) const
+        {
+            return this->firstPages[process];
+        }
+
+        PageIndex pagesEnd(uint32_t process) const
+        {
+            return this->firstPages[process + 1];
+        }
+
+        // Ascending pages of this process read by process q.
+        std::vector<PageIndex> const& getBoundary(uint32_t q) const
+        {
+            return this->boundaries[q];
+        }
+
+    private:
+        std::vector<PageIndex> firstPages;
+        std::vector<std::vector<PageIndex>> boundaries;
+    };
+
+    // Runs in every process, returns ranks valid for its own pages.
+    static std::vector<PageRank> iterate(PreparedGraph const& graph, ProcessGroup& group, Partition const& partition, double alpha, uint32_t iterations, double tolerance)
+    {
+        uint32_t me = group.getRank();
+        size_t networkSize = graph.getSize();
+        double danglingWeight = 1.0 / networkSize;
+        auto const& numLinks = graph.getNumLinks();
+        auto const& danglingNodes = graph.getDanglingNodes();
+        auto const& offsets = graph.getEdges().getOffsets();
+        auto const& sources = graph.getEdges().getSources();
+
+        // Only own pages and pages read here are kept up to date.
+        std::vector<PageRank> previousPageRanks(networkSize, 1.0 / networkSize), pageRanks(networkSize);
+
+        for (uint32_t i = 0; i < iterations; ++i) {
+            double myDangleSum = 0;
+            auto danglingEnd = segmentEnd(danglingNodes.size(), group.getSize(), me);
+            for (auto d = segmentBegin(danglingNodes.size(), group.getSize(), me); d < danglingEnd; ++d)
+                myDangleSum += previousPageRanks[danglingNodes[d]];
+
+            double dangleSum = 0;
+            auto dangleSums = allGather(group, myDangleSum);
+            for (auto d : dangleSums)
+                dangleSum += d;
+            dangleSum *= alpha;
+
+            double baseRank = dangleSum * danglingWeight + (1.0 - alpha) / networkSize;
+            double myDifference = 0;
+            for (PageIndex v = partition.pagesBegin(me); v < partition.pagesEnd(me); ++v) {
+                double rank = baseRank;
+                for (uint64_t e = offsets[v]; e < offsets[v + 1]; ++e)
+                    rank += alpha * previousPageRanks[sources[e]] / numLinks[sources[e]];
+                pageRanks[v] = rank;
+                myDifference += std::abs(previousPageRanks[v] - rank);
+            }
+
+            // One batch per peer: the partial difference, then the changed
+            // boundary ranks.
+            std::vector<std::string> outgoing(group.getSize());
+            for (uint32_t q = 0; q < group.getSize(); ++q) {
+                if (q == me)
+                    continue;
+                MessageWriter message;
+                message.putDouble(myDifference);
+                PageIndex last = 0;
+                for (auto v : partition.getBoundary(q)) {
+                    if (pageRanks[v] == previousPageRanks[v])
+                        continue;
+                    message.putVarint(v - last);
+                    message.putDouble(pageRanks[v]);
+                    last = v;
+                }
+                outgoing[q] = std::move(message.getData());
+            }
+            auto incoming = group.exchange(outgoing);
+
+            for (PageIndex v = partition.pagesBegin(me); v < partition.pagesEnd(me); ++v)
+                previousPageRanks[v] = pageRanks[v];
+
+            double difference = 0;
+            for (uint32_t q = 0; q < group.getSize(); ++q) {
+                if (q == me) {
+                    difference += myDifference;
+                    continue;
+                }
+                MessageReader message(incoming[q]);
+                difference += message.getDouble();
+                PageIndex last = 0;
+                while (not message.atEnd()) {
+                    last += message.getVarint();
+                    previousPageRanks[last] = message.getDouble();
+                }
+            }
+
+            if (difference < tolerance)
+                return pageRanks;
+        }
+
+        ASSERT(false, "Not able to find result in iterations=" << iterations);
+        return {};
+    }
+
+    // The value of every process, in process order.
+    static std::vector<double> allGather(ProcessGroup& group, double value)
+    {
+        MessageWriter message;
+        message.putDouble(value);
+        std::vector<std::string> outgoing(group.getSize(), message.getData());
+        auto incoming = group.exchange(outgoing);
+
+        std::vector<double> values(group.getSize(), value);
+        for (uint32_t q = 0; q < group.getSize(); ++q)
+            if (q != group.getRank())
+                values[q] = MessageReader(incoming[q]).getDouble();
+        return values;
+    }
+};
+
+#endif /* SRC_DISTRIBUTEDPAGERANKCOMPUTER_HPP_ */
@@ -1,35 +1,95 @@
 #ifndef SRC_IMMUTABLE_PAGE_HPP_
 #define SRC_IMMUTABLE_PAGE_HPP_
 
+#include <atomic>
 #include <functional>
 #include <iostream>
 #include <optional>
+#include <thread>
 #include <vector>
 
 #include "common.hpp"
 #include "idGenerator.hpp"
 #include "pageId.hpp"
 
+// The id is generated at most once, also when several threads prepare the
+// network at the same time, see ensureId().
 class Page {
 public:
     Page(std::string const& contentArg)
         : id("")
-        , isIdComputed(false)
+        , idState(IdState::none)
         , content(contentArg)
         , links()
     {
     }
 
+    // A page whose id is being generated is copied without it.
+    Page(Page const& other)
+        : id("")
+        , idState(IdState::none)
+        , content(other.content)
+        , links(other.links)
+    {
+        if (other.hasId()) {
+            this->id = other.id;
+            this->idState.store(IdState::generated, std::memory_order_relaxed);
+        }
+    }
+
+    Page(Page&& other)
+        : id("")
+        , idState(IdState::none)
+        , content(std::move(other.content))
+        , links(std::move(other.links))
+    {
+        if (other.hasId()) {
+            this->id = std::move(other.id);
+            this->idState.store(IdState::generated, std::memory_order_relaxed);
+        }
+    }
+
+    Page& operator=(Page other)
+    {
+        this->id = std::move(other.id);
+        this->idState.store(other.idState.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        this->content = std::move(other.content);
+        this->links = std::move(other.links);
+        return *this;
+    }
+
     void generateId(IdGenerator const& idGenerator) const
     {
-        ASSERT(not this->isIdComputed, "Generating id twice");
+        IdState expected = IdState::none;
+        bool first = this->idState.compare_exchange_strong(expected, IdState::generating, std::memory_order_acquire);
+        ASSERT(first, "Generating id twice");
         this->id = idGenerator.generateId(this->content);
-        this->isIdComputed = true;
+        this->idState.store(IdState::generated, std::memory_order_release);
+    }
+
+    // Generates the id unless it was generated before. Safe to call from
+    // several threads at once: the first one generates it, the others wait
+    // until it is there.
+    void ensureId(IdGenerator const& idGenerator) const
+    {
+        IdState expected = IdState::none;
+        if (this->idState.compare_exchange_strong(expected, IdState::generating, std::memory_order_acquire)) {
+            this->id = idGenerator.generateId(this->content);
+            this->idState.store(IdState::generated, std::memory_order_release);
+            return;
+        }
+        while (this->idState.load(std::memory_order_acquire) != IdState::generated)
+            std::this_thread::yield();
+    }
+
+    bool hasId() const
+    {
+        return this->idState.load(std::memory_order_acquire) == IdState::generated;
     }
 
     PageId getId() const
     {
-        ASSERT(this->isIdComputed, "Getting id while empty");
+        ASSERT(this->hasId(), "Getting id while empty");
         return this->id;
     }
 
@@ -44,8 +104,12 @@ public:
     }
 
 private:
+    enum class IdState : uint8_t { none,
+        generating,
+        generated };
+
     mutable PageId id;
-    mutable bool isIdComputed; // No std::optional in C++14
+    mutable std::atomic<IdState> idState; // No std::optional in C++14
 
     std::string content;
     std::vector<PageId> links;
@@ -56,7 +120,10 @@ private:
 std::ostream& operator<<(std::ostream& out, Page const& page)
 {
     out << "(";
-    out << (page.isIdComputed ? page.id : std::string("NO_ID"));
+    if (page.hasId())
+        out << page.id;
+    else
+        out << "NO_ID";
 
     out << ", \"" << page.content << "\"";
 
@@ -6,12 +6,22 @@
 #include "network.hpp"
 #include "pageIdAndRank.hpp"
 
+class PreparedGraph;
+
 class PageRankComputer {
 public:
     PageRankComputer() {};
 
     virtual std::vector<PageIdAndRank> computeForNetwork(Network const&, double alpha, uint32_t iterations, double tolerance) const = 0;
 
+    // Only the k pages with the highest rank, from the highest.
+    virtual std::vector<PageIdAndRank> computeTopK(Network const&, double alpha, uint32_t iterations, double tolerance, uint32_t k) const = 0;
+
+    // The same on a graph prepared beforehand, which can be run repeatedly.
+    virtual std::vector<PageIdAndRank> computeForGraph(PreparedGraph const&, double alpha, uint32_t iterations, double tolerance) const = 0;
+
+    virtual std::vector<PageIdAndRank> computeTopKForGraph(PreparedGraph const&, double alpha, uint32_t iterations, double tolerance, uint32_t k) const = 0;
+
     virtual std::string getName() const = 0;
 
     virtual ~PageRankComputer() { }
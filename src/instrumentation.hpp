@@ -0,0 +1,232 @@
+#ifndef SRC_INSTRUMENTATION_HPP_
+#define SRC_INSTRUMENTATION_HPP_
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "immutable/common.hpp"
+
+// Per run statistics of the computers, built with -DPAGERANK_INSTRUMENTATION
+// (cmake -DPAGERANK_INSTRUMENTATION=ON). Without it INSTRUMENT(...) drops its
+// arguments, so no clock is read and nothing is reported.
+#ifdef PAGERANK_INSTRUMENTATION
+#define INSTRUMENT(...) __VA_ARGS__
+#else
+#define INSTRUMENT(...)
+#endif
+
+// Seconds since construction or since the previous lap().
+class PhaseTimer {
+public:
+    PhaseTimer()
+        : start(std::chrono::steady_clock::now())
+    {
+    }
+
+    double lap()
+    {
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed = now - this->start;
+        this->start = now;
+        return elapsed.count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// What one run spent where. Threads only write their own slots.
+class RunReport {
+public:
+    // Phases of an iteration, `difference` being the combination of the
+    // partial residuals (computed along with the edge phase).
+    enum Phase {
+        dangleSum,
+        edges,
+        difference,
+        copy,
+        numPhases
+    };
+
+    RunReport(std::string const& computerArg, uint32_t numThreadsArg, size_t numPagesArg, uint64_t numEdgesArg)
+        : computer(computerArg)
+        , numPages(numPagesArg)
+        , numEdges(numEdgesArg)
+        , idGenerationSeconds(0)
+        , setupSeconds(0)
+        , totalSeconds(0)
+        , phaseSeconds(numThreadsArg, std::vector<double>(numPhases, 0))
+        , barrierWaitSeconds(numThreadsArg, 0)
+        , residuals()
+    {
+    }
+
+    // Id generation summed over the setup threads, setup as wall time.
+    void setSetup(double idGenerationSecondsArg, double setupSecondsArg)
+    {
+        this->idGenerationSeconds = idGenerationSecondsArg;
+        this->setupSeconds = setupSecondsArg;
+    }
+
+    void addPhase(uint32_t thread, Phase phase, double seconds)
+    {
+        this->phaseSeconds[thread][phase] += seconds;
+    }
+
+    void addBarrierWait(uint32_t thread, double seconds)
+    {
+        this->barrierWaitSeconds[thread] += seconds;
+    }
+
+    void addIteration(double residual)
+    {
+        this->residuals.push_back(residual);
+    }
+
+    // Wall time of the iterations.
+    void setTotal(double seconds)
+    {
+        this->totalSeconds = seconds;
+    }
+
+    uint32_t getIterations() const
+    {
+        return this->residuals.size();
+    }
+
+    std::vector<double> const& getResiduals() const
+    {
+        return this->residuals;
+    }
+
+    double getEdgesPerSecond() const
+    {
+        return this->totalSeconds > 0 ? this->numEdges * this->getIterations() / this->totalSeconds : 0;
+    }
+
+    // Seconds of a phase summed over threads.
+    double getPhaseSeconds(Phase phase) const
+    {
+        double seconds = 0;
+        for (auto const& thread : this->phaseSeconds)
+            seconds += thread[phase];
+        return seconds;
+    }
+
+    // One line JSON object with per thread details.
+    void writeJson(std::ostream& out) const
+    {
+        out << "{\"computer\":\"" << this->computer << "\",\"threads\":" << this->phaseSeconds.size()
+            << ",\"pages\":" << this->numPages << ",\"edges\":" << this->numEdges
+            << ",\"iterations\":" << this->getIterations() << ",\"totalSeconds\":" << this->totalSeconds
+            << ",\"idGenerationSeconds\":" << this->idGenerationSeconds << ",\"setupSeconds\":" << this->setupSeconds
+            << ",\"edgesPerSecond\":" << this->getEdgesPerSecond() << ",\"phaseSeconds\":{";
+        for (uint32_t phase = 0; phase < numPhases; ++phase) {
+            out << (phase ? "," : "") << "\"" << phaseNames()[phase] << "\":[";
+            for (uint32_t t = 0; t < this->phaseSeconds.size(); ++t)
+                out << (t ? "," : "") << this->phaseSeconds[t][phase];
+            out << "]";
+        }
+        out << "},\"barrierWaitSeconds\":[";
+        printContainer(out, this->barrierWaitSeconds) << "],\"residuals\":[";
+        printContainer(out, this->residuals) << "]}" << std::endl;
+    }
+
+    static void writeCsvHeader(std::ostream& out)
+    {
+        out << "computer,threads,pages,edges,iterations,totalSeconds,idGenerationSeconds,setupSeconds,edgesPerSecond";
+        for (uint32_t phase = 0; phase < numPhases; ++phase)
+            out << "," << phaseNames()[phase] << "Seconds";
+        out << ",barrierWaitSeconds,finalResidual" << std::endl;
+    }
+
+    // One row, phases and barrier waits summed over threads.
+    void writeCsv(std::ostream& out) const
+    {
+        out << "\"" << this->computer << "\"," << this->phaseSeconds.size() << "," << this->numPages << "," << this->numEdges
+            << "," << this->getIterations() << "," << this->totalSeconds << "," << this->idGenerationSeconds
+            << "," << this->setupSeconds << "," << this->getEdgesPerSecond();
+        for (uint32_t phase = 0; phase < numPhases; ++phase)
+            out << "," << this->getPhaseSeconds(static_cast<Phase>(phase));
+        double barrierWait = 0;
+        for (auto seconds : this->barrierWaitSeconds)
+            barrierWait += seconds;
+        out << "," << barrierWait << "," << (this->residuals.empty() ? 0 : this->residuals.back()) << std::endl;
+    }
+
+private:
+    std::string computer;
+    size_t numPages;
+    uint64_t numEdges;
+    double idGenerationSeconds;
+    double setupSeconds;
+    double totalSeconds;
+    std::vector<std::vector<double>> phaseSeconds;
+    std::vector<double> barrierWaitSeconds;
+    std::vector<double> residuals;
+
+    static char const* const* phaseNames()
+    {
+        static char const* const names[numPhases] = { "dangleSum", "edges", "difference", "copy" };
+        return names;
+    }
+};
+
+// Receives every finished RunReport. By default reports go to the file named
+// by the PAGERANK_STATS environment variable, as CSV rows when it ends with
+// ".csv" and as JSON lines otherwise, and nowhere when it is not set.
+class Instrumentation {
+public:
+    static void setSink(std::function<void(RunReport const&)> sinkArg)
+    {
+        std::lock_guard<std::mutex> lock(state().mut);
+        state().sink = std::move(sinkArg);
+    }
+
+    static void report(RunReport const& report)
+    {
+        std::lock_guard<std::mutex> lock(state().mut);
+        if (state().sink)
+            state().sink(report);
+    }
+
+private:
+    struct State {
+        std::mutex mut;
+        std::function<void(RunReport const&)> sink;
+        std::ofstream file;
+
+        State()
+        {
+            char const* path = std::getenv("PAGERANK_STATS");
+            if (path == nullptr)
+                return;
+
+            std::string name(path);
+            bool csv = name.size() >= 4 && name.compare(name.size() - 4, 4, ".csv") == 0;
+            file.open(name, std::ios::app);
+            ASSERT(file.good(), "Cannot open PAGERANK_STATS=" << name);
+            if (csv && file.tellp() == 0)
+                RunReport::writeCsvHeader(file);
+            sink = [this, csv](RunReport const& report) {
+                if (csv)
+                    report.writeCsv(file);
+                else
+                    report.writeJson(file);
+            };
+        }
+    };
+
+    static State& state()
+    {
+        static State instance;
+        return instance;
+    }
+};
+
+#endif /* SRC_INSTRUMENTATION_HPP_ */
@@ -0,0 +1,282 @@
+#ifndef SRC_LUMPEDPAGERANKCOMPUTER_HPP_
+#define SRC_LUMPEDPAGERANKCOMPUTER_HPP_
+
+#include <cmath>
+#include <vector>
+
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+#include "immutable/pageRankComputer.hpp"
+#include "parallelUtils.hpp"
+#include "preparedGraph.hpp"
+#include "presolvedGraph.hpp"
+
+// Power iteration over the core of a PresolvedGraph only, the other pages
+// are solved directly.
+//
+// The ranks the other computers converge to solve
+//   r = alpha * A * r + base,  base = (alpha * (rank of dangling pages) + 1 - alpha) / n
+// with A[v][u] = 1 / numLinks[u] for every link u -> v within the network.
+// The rank of a page only depends on the pages linking to it, so for a given
+// base an upstream page has rank base * y, y being found layer by layer
+// before iterating, and downstream pages (dangling ones included) follow
+// layer by layer from the core and upstream ranks.
+//
+// Summing the equations over all pages, the ranks r solve them exactly when
+// the core ranks do and the ranks are balanced:
+//   (1 - alpha) * (sum of ranks) + alpha * (rank leaving the network) = 1 - alpha,
+// which without links leaving the network means they sum up to 1. Every
+// iteration passes the core ranks on within the core and then picks the base
+// balancing the ranks, both linear in base, like the power iteration of the
+// other computers normalizes its ranks. It takes about as many iterations,
+// over the core only. With presolve off only the pages without links within
+// the network are taken out.
+//
+// Convergence is checked on the change of the ranks, of the core pages and
+// (to first order) of the peeled pages, like the change the other computers
+// compare with `tolerance`.
+class LumpedPageRankComputer : public PageRankComputer {
+public:
+    // Layers with fewer pages are solved by one thread.
+    static constexpr size_t minParallelLayer = 1 << 12;
+
+    LumpedPageRankComputer(uint32_t numThreadsArg, bool presolveArg = true)
+        : numThreads(numThreadsArg)
+        , presolve(presolveArg) {};
+
+    std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha, uint32_t iterations, double tolerance) const
+    {
+        PreparedGraph graph(network, numThreads);
+        return computeForGraph(graph, alpha, iterations, tolerance);
+    }
+
+    std::vector<PageIdAndRank> computeTopK(Network const& network, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        PreparedGraph graph(network, numThreads);
+        return computeTopKForGraph(graph, alpha, iterations, tolerance, k);
+    }
+
+    std::vector<PageIdAndRank> computeForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance) const
+    {
+        return graph.toResult(computeRanks(graph, alpha, iterations, tolerance));
+    }
+
+    std::vector<PageIdAndRank> computeTopKForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        return graph.toTopKResult(computeRanks(graph, alpha, iterations, tolerance), k, numThreads);
+    }
+
+    std::string getName() const
+    {
+        return "LumpedPageRankComputer[" + std::to_string(this->numThreads) + (this->presolve ? "" : ", without presolve") + "]";
+    }
+
+private:
+    uint32_t numThreads;
+    bool presolve;
+
+    // Ranks indexed by the page indices of `graph`.
+    std::vector<PageRank> computeRanks(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance) const
+    {
+        size_t networkSize = graph.getSize();
+        auto const& numLinks = graph.getNumLinks();
+        auto const& edges = graph.getEdges();
+
+        PresolvedGraph presolved(graph, numThreads, this->presolve);
+        auto const& parts = presolved.getParts();
+        auto const& numNetworkLinks = presolved.getNumNetworkLinks();
+        auto const& upstream = presolved.getUpstream();
+        auto const& downstream = presolved.getDownstream();
+        auto const& corePages = presolved.getCorePages();
+        auto const& coreEdges = presolved.getCoreEdges();
+        size_t numCore = corePages.size();
+
+        // Per unit of rank of a page, the rank of it and of the downstream
+        // pages it passes rank on to, directly or through other downstream
+        // pages, and how much of that leaves the network. Pushed along the
+        // in-links of downstream pages, whose links only go to earlier layers.
+        std::vector<double> masses(networkSize, 1.0), leaving(networkSize, 0);
+        for (PageIndex v = 0; v < networkSize; ++v) {
+            if (numLinks[v] > 0)
+                leaving[v] = 1.0 - double(numNetworkLinks[v]) / numLinks[v];
+        }
+        // Per unit of base, rank of the downstream pages not passed on by
+        // upstream or core pages.
+        double downstreamMass = 0, downstreamLeaving = 0;
+        for (auto v : downstream) {
+            downstreamMass += masses[v];
+            downstreamLeaving += leaving[v];
+            edges.forEachSource(v, [&](PageIndex source) {
+                masses[source] += alpha / numLinks[source] * masses[v];
+                leaving[source] += alpha / numLinks[source] * leaving[v];
+            });
+        }
+
+        // Two vectors of what the core pages pass on per link (their ranks
+        // times weights), so an in-link costs a single load. Iteration i reads
+        // passed[i % 2] and writes the other.
+        std::vector<double> passed[2] = { std::vector<double>(numCore), std::vector<double>(numCore) };
+        // Per core page, rank passed on by upstream pages per unit of base,
+        // and per unit of its rank, what it passes on per link and its mass
+        // and leaving rank as above.
+        std::vector<double> upstreamBase(numCore), weights(numCore), coreMasses(numCore), coreLeaving(numCore);
+        // Partial sums of every thread.
+        std::vector<double> passedMasses(numThreads), passedLeaving(numThreads), differences(numThreads);
+        std::vector<double> peeledMasses(numThreads), baseMasses(numThreads), baseLeaving(numThreads);
+        // y of upstream pages, later the ranks of all pages.
+        std::vector<PageRank> pageRanks(networkSize);
+        Barrier barrier { numThreads };
+        bool converged = false;
+
+        runInParallel(numThreads, [&](uint32_t thread) {
+            // All in-links of a peeled page come from pages solved before.
+            auto solvePage = [&](PageIndex v, double value) {
+                edges.forEachSource(v, [&](PageIndex source) { value += alpha / numLinks[source] * pageRanks[source]; });
+                pageRanks[v] = value;
+            };
+            solveLayers(presolved.getUpstreamLayers(), false, thread, barrier, [&](size_t index) { solvePage(upstream[index], 1.0); });
+
+            double peeledMass = 0, baseMass = 0, baseLeavingRank = 0;
+            auto upstreamEnd = segmentEnd(upstream.size(), numThreads, thread);
+            for (auto index = segmentBegin(upstream.size(), numThreads, thread); index < upstreamEnd; ++index) {
+                PageIndex v = upstream[index];
+                peeledMass += pageRanks[v] * masses[v];
+                baseLeavingRank += pageRanks[v] * leaving[v];
+            }
+            baseMass = peeledMass;
+            PageIndex coreBegin = coreEdges.balancedSegmentBegin(numThreads, thread);
+            PageIndex coreEnd = coreEdges.balancedSegmentBegin(numThreads, thread + 1);
+            for (PageIndex u = coreBegin; u < coreEnd; ++u) {
+                PageIndex v = corePages[u];
+                double value = 1.0;
+                edges.forEachSource(v, [&](PageIndex source) {
+                    if (parts[source] == PresolvedGraph::Part::upstream)
+                        value += alpha / numLinks[source] * pageRanks[source];
+                });
+                upstreamBase[u] = value;
+                weights[u] = alpha / numLinks[v];
+                passed[0][u] = weights[u] / networkSize;
+                coreMasses[u] = masses[v];
+                coreLeaving[u] = leaving[v];
+                baseMass += value * masses[v];
+                baseLeavingRank += value * leaving[v];
+            }
+            peeledMasses[thread] = peeledMass;
+            baseMasses[thread] = baseMass;
+            baseLeaving[thread] = baseLeavingRank;
+
+            barrier.await();
+
+            // Per unit of base, ranks of all pages but those passed on within
+            // the core, and the peeled ones only.
+            peeledMass = downstreamMass;
+            baseMass = downstreamMass;
+            baseLeavingRank = downstreamLeaving;
+            for (uint32_t t = 0; t < numThreads; ++t) {
+                peeledMass += peeledMasses[t];
+                baseMass += baseMasses[t];
+                baseLeavingRank += baseLeaving[t];
+            }
+            // As the other computers, starting from equal ranks.
+            double base = (alpha * graph.getDanglingNodes().size() / networkSize + 1.0 - alpha) / networkSize;
+
+            uint32_t i = 0;
+            for (; i < iterations; ++i) {
+                auto const& previous = passed[i % 2];
+                auto& current = passed[(i + 1) % 2];
+
+                double passedMass = 0, passedLeavingRank = 0;
+                for (PageIndex u = coreBegin; u < coreEnd; ++u) {
+                    double rank = 0;
+                    coreEdges.forEachSource(u, [&](PageIndex source) { rank += previous[source]; });
+                    current[u] = rank;
+                    passedMass += rank * coreMasses[u];
+                    passedLeavingRank += rank * coreLeaving[u];
+                }
+                passedMasses[thread] = passedMass;
+                passedLeaving[thread] = passedLeavingRank;
+
+                barrier.await();
+
+                // Every thread picks the same base balancing the ranks, no
+                // master needed.
+                passedMass = 0;
+                passedLeavingRank = 0;
+                for (uint32_t t = 0; t < numThreads; ++t) {
+                    passedMass += passedMasses[t];
+                    passedLeavingRank += passedLeaving[t];
+                }
+                double nextBase = ((1.0 - alpha) * (1.0 - passedMass) - alpha * passedLeavingRank) / ((1.0 - alpha) * baseMass + alpha * baseLeavingRank);
+                double baseChange = std::abs(nextBase - base);
+                base = nextBase;
+
+                double difference = 0;
+                for (PageIndex u = coreBegin; u < coreEnd; ++u) {
+                    double rank = current[u] + base * upstreamBase[u];
+                    difference += std::abs(rank - previous[u] / weights[u]) * coreMasses[u];
+                    current[u] = rank * weights[u];
+                }
+                differences[thread] = difference;
+
+                barrier.await();
+
+                double totalDifference = baseChange * peeledMass;
+                for (uint32_t t = 0; t < numThreads; ++t)
+                    totalDifference += differences[t];
+                if (totalDifference < tolerance)
+                    break;
+            }
+            if (i == iterations)
+                return;
+
+            auto const& solved = passed[(i + 1) % 2];
+            for (PageIndex u = coreBegin; u < coreEnd; ++u)
+                pageRanks[corePages[u]] = solved[u] / weights[u];
+            for (auto index = segmentBegin(upstream.size(), numThreads, thread); index < upstreamEnd; ++index)
+                pageRanks[upstream[index]] *= base;
+
+            barrier.await();
+
+            solveLayers(presolved.getDownstreamLayers(), true, thread, barrier, [&](size_t index) { solvePage(downstream[index], base); });
+            if (thread == 0)
+                converged = true;
+        });
+
+        ASSERT(converged, "Not able to find result in iterations=" << iterations);
+        return pageRanks;
+    }
+
+    // Calls solve(i) for the indices i of every layer, in order or
+    // backwards, a layer spread over the threads. Runs of small layers are
+    // solved by the first thread alone, which saves a barrier per layer.
+    template <typename Solve>
+    void solveLayers(std::vector<size_t> const& layers, bool backwards, uint32_t thread, Barrier& barrier, Solve const& solve) const
+    {
+        size_t numLayers = layers.size() - 1;
+        auto layerAt = [&](size_t k) { return backwards ? numLayers - 1 - k : k; };
+        auto layerSize = [&](size_t k) { return layers[layerAt(k) + 1] - layers[layerAt(k)]; };
+
+        size_t k = 0;
+        while (k < numLayers) {
+            if (layerSize(k) >= minParallelLayer) {
+                size_t begin = layers[layerAt(k)];
+                auto end = begin + segmentEnd(layerSize(k), this->numThreads, thread);
+                for (auto i = begin + segmentBegin(layerSize(k), this->numThreads, thread); i < end; ++i)
+                    solve(i);
+                ++k;
+            } else {
+                size_t first = k;
+                while (k < numLayers && layerSize(k) < minParallelLayer)
+                    ++k;
+                if (thread == 0) {
+                    for (size_t j = first; j < k; ++j)
+                        for (auto i = layers[layerAt(j)]; i < layers[layerAt(j) + 1]; ++i)
+                            solve(i);
+                }
+            }
+            barrier.await();
+        }
+    }
+};
+
+#endif /* SRC_LUMPEDPAGERANKCOMPUTER_HPP_ */
@@ -0,0 +1,152 @@
+#ifndef SRC_MACHINECALIBRATION_HPP_
+#define SRC_MACHINECALIBRATION_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "compressedCsrGraph.hpp"
+#include "csrGraph.hpp"
+#include "parallelUtils.hpp"
+
+// Speed of the machine as seen by the power iteration: the cost of a pull
+// iteration per page and in-link with either kernel, how much faster more
+// threads pull, and the cost of the threads and barriers of a multithreaded
+// run. Measured once per process on a synthetic graph of calibrationUnits,
+// which takes a fraction of a second.
+struct MachineCalibration {
+    static constexpr uint32_t calibrationPages = 1 << 18;
+    static constexpr uint32_t calibrationInLinks = 8;
+    static constexpr uint64_t calibrationUnits = uint64_t(calibrationPages) * (1 + calibrationInLinks);
+
+    uint32_t hardwareThreads;
+    double plainSecondsPerUnit;
+    double compressedSecondsPerUnit;
+    // Starting and joining one thread.
+    double threadStartSeconds;
+    // One round of a barrier of hardwareThreads threads, at least two.
+    double barrierSeconds;
+    // speedups[t - 1] is how much faster t threads pull than one, for t up to
+    // hardwareThreads. Memory bandwidth keeps it well below t on most machines.
+    std::vector<double> speedups;
+
+    // More threads than measured pull no faster.
+    double speedup(uint32_t numThreads) const
+    {
+        ASSERT(numThreads > 0 && not this->speedups.empty(), "No speedup of threads=" << numThreads);
+        return this->speedups[std::min<size_t>(numThreads, this->speedups.size()) - 1];
+    }
+
+    static MachineCalibration const& get()
+    {
+        static MachineCalibration const calibration = measure();
+        return calibration;
+    }
+
+    static MachineCalibration measure()
+    {
+        MachineCalibration calibration;
+        calibration.hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        // Half of the in-links from nearby pages, as in crawls, so the
+        // compressed kernel sees realistic gaps.
+        CsrGraphBuilder builder(calibrationPages, 1);
+        uint64_t state = 2021;
+        for (PageIndex v = 0; v < calibrationPages; ++v) {
+            for (uint32_t i = 0; i < calibrationInLinks; ++i) {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                uint32_t random = state >> 33;
+                PageIndex source = i % 2 == 0 ? random % calibrationPages : (v + random % 1024) % calibrationPages;
+                builder.addEdge(0, source, v);
+            }
+        }
+        CsrGraph plain = builder.build();
+        CompressedCsrGraph compressed(plain, 1);
+        double plainSeconds = secondsPerIteration(plain, 1);
+        calibration.plainSecondsPerUnit = plainSeconds / calibrationUnits;
+        calibration.compressedSecondsPerUnit = secondsPerIteration(compressed, 1) / calibrationUnits;
+        calibration.speedups = { 1 };
+        for (uint32_t numThreads = 2; numThreads <= calibration.hardwareThreads; ++numThreads)
+            calibration.speedups.push_back(plainSeconds / secondsPerIteration(plain, numThreads));
+
+        uint32_t numStarts = 8;
+        calibration.threadStartSeconds = bestOf(3, [numStarts] {
+            for (uint32_t i = 0; i < numStarts; ++i)
+                std::thread([] {}).join();
+        }) / numStarts;
+
+        uint32_t numRounds = 100;
+        uint32_t numThreads = std::max(2u, calibration.hardwareThreads);
+        calibration.barrierSeconds = bestOf(3, [numRounds, numThreads] {
+            Barrier barrier(numThreads);
+            runInParallel(numThreads, [&](uint32_t) {
+                for (uint32_t i = 0; i < numRounds; ++i)
+                    barrier.await();
+            });
+        }) / numRounds;
+        return calibration;
+    }
+
+    std::string describe() const
+    {
+        std::ostringstream out;
+        out << "hardwareThreads=" << this->hardwareThreads << ", plainNsPerUnit=" << this->plainSecondsPerUnit * 1e9
+            << ", compressedNsPerUnit=" << this->compressedSecondsPerUnit * 1e9 << ", threadStartUs=" << this->threadStartSeconds * 1e6
+            << ", barrierUs=" << this->barrierSeconds * 1e6 << ", speedups=";
+        for (size_t t = 0; t < this->speedups.size(); ++t)
+            out << (t == 0 ? "" : "/") << this->speedups[t];
+        return out.str();
+    }
+
+private:
+    template <typename Func>
+    static double bestOf(uint32_t repetitions, Func const& func)
+    {
+        double best = std::numeric_limits<double>::infinity();
+        for (uint32_t i = 0; i < repetitions; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            func();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    // The pull loop of the computers, its pages split over numThreads
+    // threads as theirs are. Timed between barriers, so starting the threads
+    // is not included.
+    template <typename InLinks>
+    static double secondsPerIteration(InLinks const& edges, uint32_t numThreads)
+    {
+        std::vector<double> previousPageRanks(calibrationPages, 1.0 / calibrationPages), pageRanks(calibrationPages);
+        double seconds = std::numeric_limits<double>::infinity();
+        Barrier barrier(numThreads);
+        runInParallel(numThreads, [&](uint32_t thread) {
+            PageIndex begin = edges.balancedSegmentBegin(numThreads, thread);
+            PageIndex end = edges.balancedSegmentBegin(numThreads, thread + 1);
+            for (uint32_t i = 0; i < 3; ++i) {
+                barrier.await();
+                auto start = std::chrono::steady_clock::now();
+                for (PageIndex v = begin; v < end; ++v) {
+                    double rank = 0;
+                    edges.forEachSource(v, [&](PageIndex source) {
+                        rank += 0.85 * previousPageRanks[source] / calibrationInLinks;
+                    });
+                    pageRanks[v] = rank;
+                }
+                barrier.await();
+                // Every thread is done by now.
+                if (thread == 0)
+                    seconds = std::min(seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+        });
+        // Keeps the loop from being optimized away.
+        ASSERT(pageRanks[0] >= 0, "Invalid calibration rank");
+        return seconds;
+    }
+};
+
+#endif /* SRC_MACHINECALIBRATION_HPP_ */
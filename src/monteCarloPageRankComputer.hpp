@@ -0,0 +1,118 @@
+#ifndef SRC_MONTECARLOPAGERANKCOMPUTER_HPP_
+#define SRC_MONTECARLOPAGERANKCOMPUTER_HPP_
+
+#include <random>
+#include <vector>
+
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+#include "immutable/pageRankComputer.hpp"
+#include "preparedGraph.hpp"
+#include "parallelUtils.hpp"
+
+// Approximate PageRank from random walks. About numWalks walks in total start
+// evenly from every page (at least one per page); each step ends the walk with
+// probability 1 - alpha, otherwise follows a random link (a dangling page
+// jumps to a random page, a link leaving the network ends the walk). The rank
+// of a page is proportional to the visits it gets, the relative error of a
+// rank shrinks as 1 / sqrt(its visits), so it is controlled by numWalks.
+// Every thread owns its generator and counters, results depend only on seed
+// and numThreads.
+//
+// `tolerance` is not used, `iterations` bounds the length of a walk the way it
+// bounds the number of power iterations.
+class MonteCarloPageRankComputer : public PageRankComputer {
+public:
+    MonteCarloPageRankComputer(uint32_t numThreadsArg, uint64_t numWalksArg, uint64_t seedArg = 2021)
+        : numThreads(numThreadsArg)
+        , numWalks(numWalksArg)
+        , seed(seedArg) {};
+
+    std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha, uint32_t iterations, double tolerance) const
+    {
+        PreparedGraph graph(network, numThreads);
+        return computeForGraph(graph, alpha, iterations, tolerance);
+    }
+
+    std::vector<PageIdAndRank> computeTopK(Network const& network, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        PreparedGraph graph(network, numThreads);
+        return computeTopKForGraph(graph, alpha, iterations, tolerance, k);
+    }
+
+    std::vector<PageIdAndRank> computeForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double) const
+    {
+        return graph.toResult(computeRanks(graph, alpha, iterations));
+    }
+
+    std::vector<PageIdAndRank> computeTopKForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double, uint32_t k) const
+    {
+        return graph.toTopKResult(computeRanks(graph, alpha, iterations), k, numThreads);
+    }
+
+    std::string getName() const
+    {
+        return "MonteCarloPageRankComputer[" + std::to_string(this->numThreads) + ", " + std::to_string(this->numWalks) + " walks]";
+    }
+
+private:
+    uint32_t numThreads;
+    uint64_t numWalks;
+    uint64_t seed;
+
+    std::vector<PageRank> computeRanks(PreparedGraph const& graph, double alpha, uint32_t maxSteps) const
+    {
+        size_t networkSize = graph.getSize();
+        uint64_t walksPerPage = std::max<uint64_t>(1, (numWalks + networkSize - 1) / std::max<size_t>(networkSize, 1));
+        CsrGraph outLinks = graph.getEdges().transposed(numThreads);
+        auto const& numLinks = graph.getNumLinks();
+        auto const& offsets = outLinks.getOffsets();
+        auto const& targets = outLinks.getSources();
+
+        // Visits counted by every thread separately, no shared writes during the walks.
+        std::vector<std::vector<uint32_t>> visits(numThreads);
+        runInParallel(numThreads, [&](uint32_t thread) {
+            std::mt19937_64 random(seed + thread);
+            std::uniform_real_distribution<double> coin(0.0, 1.0);
+            std::vector<uint32_t>& myVisits = visits[thread];
+            myVisits.assign(networkSize, 0);
+
+            auto startsEnd = segmentEnd(networkSize, numThreads, thread);
+            for (auto start = segmentBegin(networkSize, numThreads, thread); start < startsEnd; ++start) {
+                for (uint64_t w = 0; w < walksPerPage; ++w) {
+                    PageIndex v = start;
+                    for (uint32_t step = 0;; ++step) {
+                        ++myVisits[v];
+                        if (step == maxSteps || coin(random) >= alpha)
+                            break;
+                        if (numLinks[v] == 0) {
+                            v = std::uniform_int_distribution<PageIndex>(0, networkSize - 1)(random);
+                            continue;
+                        }
+                        auto link = std::uniform_int_distribution<uint32_t>(0, numLinks[v] - 1)(random);
+                        // Links past the in-network ones leave the network.
+                        if (link >= offsets[v + 1] - offsets[v])
+                            break;
+                        v = targets[offsets[v] + link];
+                    }
+                }
+            }
+        });
+
+        // Every walk leaves 1 / (1 - alpha) visits on average.
+        double scale = (1.0 - alpha) / (static_cast<double>(networkSize) * walksPerPage);
+        std::vector<PageRank> pageRanks(networkSize);
+        runInParallel(numThreads, [&](uint32_t thread) {
+            auto end = segmentEnd(networkSize, numThreads, thread);
+            for (auto v = segmentBegin(networkSize, numThreads, thread); v < end; ++v) {
+                uint64_t total = 0;
+                for (auto const& threadVisits : visits)
+                    total += threadVisits[v];
+                pageRanks[v] = total * scale;
+            }
+        });
+        return pageRanks;
+    }
+};
+
+#endif /* SRC_MONTECARLOPAGERANKCOMPUTER_HPP_ */
@@ -2,56 +2,214 @@
 #define SRC_MULTITHREADEDPAGERANKCOMPUTER_HPP_
 
 #include <numeric>
-#include <unordered_map>
 #include <vector>
 
 #include <atomic>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <thread>
 
 #include "immutable/network.hpp"
 #include "immutable/pageIdAndRank.hpp"
 #include "immutable/pageRankComputer.hpp"
+#include "asyncRun.hpp"
+#include "blockPowerIteration.hpp"
+#include "checkpoint.hpp"
+#include "compressedCsrGraph.hpp"
+#include "csrGraph.hpp"
+#include "instrumentation.hpp"
+#include "preparedGraph.hpp"
+#include "parallelUtils.hpp"
+#include "runBudget.hpp"
+#include "tracer.hpp"
 
 class MultiThreadedPageRankComputer : public PageRankComputer {
 public:
-    MultiThreadedPageRankComputer(uint32_t numThreadsArg)
-        : numThreads(numThreadsArg) {};
+    // With compressEdgesArg networks are prepared with compressed in-links
+    // (see PreparedGraph::compressEdges()), trading decoding work for memory
+    // bandwidth. Prepared graphs are run with the in-links they have.
+    //
+    // With checkpointArg.everyIterations > 0 the ranks are saved to
+    // checkpointArg.path every that many iterations, and a run finding a
+    // checkpoint of the same graph and alpha there resumes from it, any other
+    // file there is overwritten. The checkpoint stays after the run, remove
+    // it to start over. One that cannot be written is skipped and logged
+    // (see CheckpointWriter), the run goes on.
+    MultiThreadedPageRankComputer(uint32_t numThreadsArg, bool compressEdgesArg = false, CheckpointConfig checkpointArg = { "", 0 })
+        : numThreads(numThreadsArg)
+        , compressEdges(compressEdgesArg)
+        , checkpoint(checkpointArg) {};
 
     std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha, uint32_t iterations, double tolerance) const
     {
-        // Setting up additional structures for the network.
-        generateIds(network);
-
-        std::unordered_map<PageId, std::atomic<PageRank>, PageIdHash> previousPageHashMap, pageHashMap;
-        std::unordered_map<PageId, uint32_t, PageIdHash> numLinks;
-        std::vector<PageId> danglingNodes, pages;
-        // <a, b> <=> a -> b
-        std::vector<std::pair<PageId, PageId>> edges;
-
-        pages.reserve(network.getPages().size());
-
-        for (auto const& page : network.getPages()) {
-            auto page_id = page.getId();
-            auto page_links = page.getLinks();
-            auto links_sz = page_links.size();
-
-            pages.push_back(page_id);
-            previousPageHashMap.emplace(page_id, 1.0 / network.getSize());
-            pageHashMap.emplace(page_id, 1.0 / network.getSize());
-            //previousPageHashMap[page_id] = 1.0 / network.getSize();
-            numLinks[page_id] = links_sz;
-            if (links_sz == 0)
-                danglingNodes.push_back(page_id);
-            for (auto const& link : page_links)
-                edges.push_back({ page_id, link });
+        PreparedGraph graph(network, numThreads);
+        prepareInLinks(graph);
+        return computeForGraph(graph, alpha, iterations, tolerance);
+    }
+
+    std::vector<PageIdAndRank> computeTopK(Network const& network, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        PreparedGraph graph(network, numThreads);
+        prepareInLinks(graph);
+        return computeTopKForGraph(graph, alpha, iterations, tolerance, k);
+    }
+
+    std::vector<PageIdAndRank> computeForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance) const
+    {
+        return graph.toResult(computeRanks(graph, alpha, iterations, tolerance));
+    }
+
+    std::vector<PageIdAndRank> computeTopKForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        // Per thread heaps, only k pages are materialized.
+        return graph.toTopKResult(computeRanks(graph, alpha, iterations, tolerance), k, numThreads);
+    }
+
+    // Best effort: stops once converged, after `iterations` or at the first
+    // iteration boundary after the budget is exhausted, and returns the ranks
+    // reached. Setting up the graph is not interrupted.
+    BestEffortResult computeWithBudget(Network const& network, double alpha, uint32_t iterations, double tolerance, RunBudget const& budget) const
+    {
+        PreparedGraph graph(network, numThreads);
+        prepareInLinks(graph);
+        return computeWithBudget(graph, alpha, iterations, tolerance, budget);
+    }
+
+    BestEffortResult computeWithBudget(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, RunBudget const& budget) const
+    {
+        RunStatus status = RunStatus::none();
+        auto pageRanks = computeRanks(graph, alpha, iterations, tolerance, &budget, nullptr, status);
+        return { graph.toResult(pageRanks), status };
+    }
+
+    // Runs in a background thread, which sets up the graph and then drives
+    // the workers, so the caller can prepare the next network meanwhile.
+    // Stops like computeWithBudget when cancelled, onIteration gets the
+    // progress after every iteration.
+    AsyncRun computeAsync(Network const& network, double alpha, uint32_t iterations, double tolerance, RunProgress::Callback onIteration = nullptr) const
+    {
+        auto budget = std::make_shared<RunBudget>();
+        auto progress = std::make_shared<RunProgress>(std::move(onIteration));
+        MultiThreadedPageRankComputer computer = *this;
+        auto result = std::async(std::launch::async, [computer, &network, alpha, iterations, tolerance, budget, progress] {
+            PreparedGraph graph(network, computer.numThreads);
+            computer.prepareInLinks(graph);
+            return computer.computeWithProgress(graph, alpha, iterations, tolerance, *budget, *progress);
+        });
+        return AsyncRun(budget, progress, std::move(result));
+    }
+
+    AsyncRun computeAsync(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, RunProgress::Callback onIteration = nullptr) const
+    {
+        auto budget = std::make_shared<RunBudget>();
+        auto progress = std::make_shared<RunProgress>(std::move(onIteration));
+        MultiThreadedPageRankComputer computer = *this;
+        auto result = std::async(std::launch::async, [computer, &graph, alpha, iterations, tolerance, budget, progress] {
+            return computer.computeWithProgress(graph, alpha, iterations, tolerance, *budget, *progress);
+        });
+        return AsyncRun(budget, progress, std::move(result));
+    }
+
+    // One result per parameter set, the graph is set up once and all rank
+    // vectors are iterated together, interleaved per page, so each in-link
+    // load serves every parameter set. Stops once all of them converge.
+    std::vector<std::vector<PageIdAndRank>> computeSweep(Network const& network, std::vector<PageRankParameters> const& parameters, uint32_t iterations) const
+    {
+        PreparedGraph graph(network, numThreads);
+        return computeSweep(graph, parameters, iterations);
+    }
+
+    std::vector<std::vector<PageIdAndRank>> computeSweep(PreparedGraph const& graph, std::vector<PageRankParameters> const& parameters, uint32_t iterations) const
+    {
+        std::vector<PageRank> pageRanks = BlockPowerIteration::run(
+            graph, numThreads, parameters, BlockPowerIteration::uniformTeleport(graph.getSize(), parameters.size()), iterations);
+        ASSERT(not pageRanks.empty(), "Not able to find result in iterations=" << iterations);
+
+        std::vector<std::vector<PageIdAndRank>> results;
+        for (size_t q = 0; q < parameters.size(); ++q)
+            results.push_back(BlockPowerIteration::materialize(graph, pageRanks, parameters.size(), q));
+        return results;
+    }
+
+    std::string getName() const
+    {
+        return "MultiThreadedPageRankComputer[" + std::to_string(this->numThreads) + (this->compressEdges ? ", compressed" : "") + "]";
+    }
+
+private:
+    uint32_t numThreads;
+    bool compressEdges;
+    CheckpointConfig checkpoint;
+
+    // Compresses the in-links of a graph prepared for this computer, once.
+    void prepareInLinks(PreparedGraph& graph) const
+    {
+        if (compressEdges)
+            graph.compressEdges(numThreads);
+    }
+
+    // Converged ranks indexed by the page indices of `graph`.
+    std::vector<PageRank> computeRanks(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance) const
+    {
+        RunStatus status = RunStatus::none();
+        auto pageRanks = computeRanks(graph, alpha, iterations, tolerance, nullptr, nullptr, status);
+        ASSERT(status.converged, "Not able to find result in iterations=" << iterations);
+        return pageRanks;
+    }
+
+    BestEffortResult computeWithProgress(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, RunBudget const& budget, RunProgress& progress) const
+    {
+        RunStatus status = RunStatus::none();
+        auto pageRanks = computeRanks(graph, alpha, iterations, tolerance, &budget, &progress, status);
+        return { graph.toResult(pageRanks), status };
+    }
+
+    // Ranks when the run stopped, also early once `budget` (if any) is
+    // exhausted. `progress` (if any) is updated after every iteration.
+    std::vector<PageRank> computeRanks(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance,
+        RunBudget const* budget, RunProgress* progress, RunStatus& status) const
+    {
+        if (graph.hasCompressedEdges())
+            return computeRanks(graph, graph.getCompressedEdges(), alpha, iterations, tolerance, budget, progress, status);
+        return computeRanks(graph, graph.getEdges(), alpha, iterations, tolerance, budget, progress, status);
+    }
+
+    // InLinks is CsrGraph or CompressedCsrGraph.
+    template <typename InLinks>
+    std::vector<PageRank> computeRanks(PreparedGraph const& graph, InLinks const& inLinks, double alpha, uint32_t iterations, double tolerance,
+        RunBudget const* budget, RunProgress* progress, RunStatus& status) const
+    {
+        std::vector<PageRank> previousPageRanks(graph.getSize(), 1.0 / graph.getSize()), pageRanks(graph.getSize());
+
+        uint32_t firstIteration = 0;
+        std::unique_ptr<CheckpointWriter> checkpointWriter;
+        if (checkpoint.everyIterations > 0) {
+            Checkpoint::Key key { graph.getSize(), graph.getNumEdges(), graph.getFingerprint(), alpha };
+            Checkpoint saved;
+            if (Checkpoint::read(checkpoint.path, key, saved)) {
+                firstIteration = saved.iteration;
+                previousPageRanks = std::move(saved.pageRanks);
+            }
+            checkpointWriter.reset(new CheckpointWriter(checkpoint.path, key));
         }
+        // Nothing left to iterate, also when resumed at the end: a run with
+        // a budget returns the ranks it starts from.
+        if (budget != nullptr && firstIteration >= iterations) {
+            status = RunStatus::none();
+            return previousPageRanks;
+        }
+        ASSERT(firstIteration < iterations, "Not able to find result in iterations=" << iterations << ", resumed after=" << firstIteration);
 
         // Partial values for each thread.
         std::vector<double> dangleSums(numThreads, 0), differences(numThreads, 0);
         std::atomic<double> dangleSum { 0 };
 
+        // Only built with instrumentation.
+        INSTRUMENT(RunReport report(getName(), numThreads, graph.getSize(), graph.getNumEdges());)
+        INSTRUMENT(report.setSetup(graph.getIdGenerationSeconds(), graph.getSetupSeconds());)
+        INSTRUMENT(PhaseTimer runTimer;)
+
         // Setting up thread specific and synchronization structures.
         CyclicBarrier barrier { numThreads };
         std::atomic<bool> done { false };
@@ -60,87 +218,88 @@ public:
 
         for (uint32_t i = 0; i < numThreads; ++i)
             threads.push_back({ std::thread {
-                                    MultiThreadedPageRankComputer::pageRankWorkFunc,
+                                    MultiThreadedPageRankComputer::pageRankWorkFunc<InLinks>,
                                     i,
                                     std::ref(barrier),
                                     std::ref(done),
                                     numThreads,
-                                    network.getSize(),
+                                    graph.getSize(),
                                     alpha,
                                     std::ref(dangleSum),
-                                    std::ref(pages),
-                                    std::ref(danglingNodes),
-                                    std::ref(numLinks),
-                                    std::ref(edges),
-                                    std::ref(previousPageHashMap),
-                                    std::ref(pageHashMap),
+                                    std::ref(graph.getDanglingNodes()),
+                                    std::ref(graph.getNumLinks()),
+                                    std::ref(inLinks),
+                                    std::ref(previousPageRanks),
+                                    std::ref(pageRanks),
                                     std::ref(dangleSums[i]),
-                                    std::ref(differences[i]) },
+                                    std::ref(differences[i]),
+                                    firstIteration INSTRUMENT(, std::ref(report)) },
                 ThreadRAII::DtorAction::join });
 
-        for (uint32_t i = 0; i < iterations; ++i) {
+        if (progress != nullptr)
+            progress->start(graph.getNumEdges());
+        TRACE(Tracer::setThreadName("master");)
+        TRACE(uint64_t traceBegin = Tracer::now();)
+        for (uint32_t i = firstIteration; i < iterations; ++i) {
             double difference;
             dangleSum = difference = 0;
 
             barrier.wait();
+            TRACE(traceBegin = Tracer::lap("wait", traceBegin, i);)
 
             // Partial dangle sums calculated.
             for (auto d : dangleSums)
                 atomic_increase(dangleSum, d);
             atomic_multiply(dangleSum, alpha);
+            TRACE(traceBegin = Tracer::lap("dangleSum", traceBegin, i);)
 
             // Dangle sums calculated.
             barrier.goOn();
 
             barrier.wait();
-            // PageRanks partially calculated.
-            barrier.goOn();
-
-            barrier.wait();
-            // PageRanks calculated.
-            barrier.goOn();
-
-            barrier.wait();
-            // Partial differences calculated.
+            TRACE(traceBegin = Tracer::lap("wait", traceBegin, i);)
+            // PageRanks and partial differences calculated.
+            INSTRUMENT(PhaseTimer differenceTimer;)
             for (auto d : differences)
                 difference += d;
+            INSTRUMENT(report.addPhase(0, RunReport::difference, differenceTimer.lap());)
+            INSTRUMENT(report.addIteration(difference);)
+            TRACE(traceBegin = Tracer::lap("difference", traceBegin, i);)
 
             barrier.goOn();
-            // previousPageHashMap recalculated.
+            // Published while the workers copy the ranks.
+            if (progress != nullptr)
+                progress->update(i + 1, difference);
+            // previousPageRanks recalculated.
             barrier.wait();
+            TRACE(traceBegin = Tracer::lap("wait", traceBegin, i);)
 
-            if (difference < tolerance) {
+            // Workers wait here, so the budget is checked without a barrier of its own.
+            if (difference < tolerance || i + 1 == iterations || (budget != nullptr && budget->isExhausted())) {
                 done = true;
                 barrier.goOn();
+                for (auto& thread : threads)
+                    thread.get().join();
                 // Threads finished, cleaned up.
-
-                std::vector<PageIdAndRank> result;
-                for (auto const& page_id : pages)
-                    result.push_back(PageIdAndRank(page_id, pageHashMap[page_id].load()));
-
-                ASSERT(result.size() == network.getSize(),
-                    "Invalid result size=" << result.size() << ", for network" << network);
-
-                return result;
-            } else if (i + 1 == iterations) {
-                done = true;
+                INSTRUMENT(report.setTotal(runTimer.lap());)
+                INSTRUMENT(Instrumentation::report(report);)
+                status = { i + 1, difference, difference < tolerance };
+                return pageRanks;
+            } else if (checkpointWriter && (i + 1) % checkpoint.everyIterations == 0) {
+                // Workers wait, previousPageRanks holds the ranks after i + 1
+                // iterations. Only copied here, written in the background.
+                checkpointWriter->offer(i + 1, previousPageRanks);
+                TRACE(traceBegin = Tracer::lap("checkpoint", traceBegin, i);)
             }
 
-            // Start calculating partial dangle sums or finish work if `done`.
+            // Start calculating partial dangle sums.
             barrier.goOn();
         }
 
-        ASSERT(false, "Not able to find result in iterations=" << iterations);
-    }
-
-    std::string getName() const
-    {
-        return "MultiThreadedPageRankComputer[" + std::to_string(this->numThreads) + "]";
+        // Unreachable, the last iteration stops the run.
+        return {};
     }
 
-private:
-    uint32_t numThreads;
-
     // Atomic y += x using CAS idiom.
     static void atomic_increase(std::atomic<double>& y, double x)
     {
@@ -157,67 +316,6 @@ private:
         }
     }
 
-    // Taken from labs, also featured in Meyers' C++ book.
-    // Safe thread creation and freeing.
-    class ThreadRAII {
-    public:
-        enum class DtorAction { join,
-            detach };
-
-        ThreadRAII(std::thread&& t, DtorAction a)
-            : action(a)
-            , t(std::move(t))
-        {
-        }
-        ThreadRAII(ThreadRAII&& t)
-            : action(t.action)
-            , t(std::move(t.get()))
-        {
-        }
-        ~ThreadRAII()
-        {
-            if (t.joinable()) {
-                if (action == DtorAction::join)
-                    t.join();
-                else
-                    t.detach();
-            }
-        }
-
-        std::thread& get() { return t; }
-
-    private:
-        DtorAction action;
-        std::thread t;
-    };
-
-    // Worker function for the thread to generate ids.
-    static void gen_id_thread(std::atomic<size_t>& frst_free, std::vector<Page> const& pages, IdGenerator const& idGen)
-    {
-        while (true) {
-            auto i = frst_free++;
-            if (i >= pages.size())
-                break;
-            pages[i].generateId(idGen);
-        }
-    }
-
-    // Multithreaded id generating.
-    void generateIds(Network const& network) const
-    {
-        std::vector<ThreadRAII> threads;
-        threads.reserve(numThreads);
-        std::atomic<size_t> frst_free { 0 };
-
-        for (uint32_t i = 0; i < numThreads; ++i)
-            threads.push_back({ std::thread {
-                                    MultiThreadedPageRankComputer::gen_id_thread,
-                                    std::ref(frst_free),
-                                    std::ref(network.getPages()),
-                                    std::ref(network.getGenerator()) },
-                ThreadRAII::DtorAction::join });
-    }
-
     class CyclicBarrier {
     public:
         CyclicBarrier(uint32_t parties)
@@ -277,6 +375,7 @@ private:
     };
 
     // Worker function for a thread calculating PageRanks.
+    template <typename InLinks>
     static void pageRankWorkFunc(
         // Synchronization.
         uint32_t index, // Belongs to [0, numThreads), is unique.
@@ -287,58 +386,69 @@ private:
         size_t networkSize,
         double alpha,
         std::atomic<double> const& dangleSum,
-        std::vector<PageId> const& pages,
-        std::vector<PageId> const& danglingNodes,
-        std::unordered_map<PageId, uint32_t, PageIdHash> const& numLinks,
-        std::vector<std::pair<PageId, PageId>> const& edges, // first -> second
+        std::vector<PageIndex> const& danglingNodes,
+        std::vector<uint32_t> const& numLinks,
+        InLinks const& edges, // In-links of every page.
         // First read, then write.
-        std::unordered_map<PageId, std::atomic<PageRank>, PageIdHash>& previousPageHashMap,
+        std::vector<PageRank>& previousPageRanks,
         // Write only network data.
-        std::unordered_map<PageId, std::atomic<PageRank>, PageIdHash>& pageHashMap,
+        std::vector<PageRank>& pageRanks,
         double& myDangleSum,
-        double& difference)
+        double& difference,
+        uint32_t TRACE(iteration) // Unnamed without tracing.
+        INSTRUMENT(, RunReport& report)) // Only with instrumentation.
     {
         double danglingWeight = 1.0 / networkSize;
 
+        // Pages of this thread, balanced by the number of their in-links.
+        PageIndex pagesBegin = edges.balancedSegmentBegin(numThreads, index);
+        PageIndex pagesEnd = edges.balancedSegmentBegin(numThreads, index + 1);
+
+        INSTRUMENT(PhaseTimer timer;)
+        TRACE(Tracer::setThreadName("worker " + std::to_string(index));)
+        TRACE(uint64_t traceBegin = Tracer::now();)
         while (not done.load()) {
             myDangleSum = difference = 0;
+            INSTRUMENT(timer.lap();)
 
             // Calculate the weight of dangling nodes of this thread.
-            uint64_t danglingSegment = danglingNodes.size() / numThreads + 1;
-            for (uint64_t i = index * danglingSegment; i < (index + 1) * danglingSegment && i < danglingNodes.size(); ++i)
-                myDangleSum += previousPageHashMap.at(danglingNodes[i]).load();
+            auto danglingEnd = segmentEnd(danglingNodes.size(), numThreads, index);
+            for (auto i = segmentBegin(danglingNodes.size(), numThreads, index); i < danglingEnd; ++i)
+                myDangleSum += previousPageRanks[danglingNodes[i]];
+            INSTRUMENT(report.addPhase(index, RunReport::dangleSum, timer.lap());)
+            TRACE(traceBegin = Tracer::lap("dangleSum", traceBegin, iteration);)
 
             barrier.await();
-
-            // Assign base PageRanks, which are independent of neighbours,
-            // for pages of this thread.
-            uint64_t pageSegment = pages.size() / numThreads + 1;
-            for (uint64_t i = index * pageSegment; i < (index + 1) * pageSegment && i < pages.size(); ++i)
-                pageHashMap[pages[i]] = dangleSum.load() * danglingWeight + (1.0 - alpha) / networkSize;
-
-            barrier.await();
-
-            // Increase PageRanks accordingly to the edge segment for this thread.
-            // FIXME maybe no need for atomic increase, just local sum and then
-            // sum in main
-            uint64_t edgeSegment = edges.size() / numThreads + 1;
-            for (uint64_t i = index * edgeSegment; i < (index + 1) * edgeSegment && i < edges.size(); ++i)
-                atomic_increase(pageHashMap[edges[i].second], alpha * previousPageHashMap.at(edges[i].first).load() / numLinks.at(edges[i].first));
-
-            barrier.await();
-
-            // Calculate the difference for pages of this thread.
-            for (uint64_t i = index * pageSegment; i < (index + 1) * pageSegment && i < pages.size(); ++i)
-                difference += std::abs(previousPageHashMap.at(pages[i]).load() - pageHashMap[pages[i]].load());
+            INSTRUMENT(report.addBarrierWait(index, timer.lap());)
+            TRACE(traceBegin = Tracer::lap("barrier", traceBegin, iteration);)
+
+            // Pull PageRanks of pages of this thread from their in-links, only
+            // this thread writes them so no atomics are needed.
+            double baseRank = dangleSum.load() * danglingWeight + (1.0 - alpha) / networkSize;
+            for (PageIndex v = pagesBegin; v < pagesEnd; ++v) {
+                double rank = baseRank;
+                edges.forEachSource(v, [&](PageIndex source) {
+                    rank += alpha * previousPageRanks[source] / numLinks[source];
+                });
+                pageRanks[v] = rank;
+                difference += std::abs(previousPageRanks[v] - rank);
+            }
+            INSTRUMENT(report.addPhase(index, RunReport::edges, timer.lap());)
+            TRACE(traceBegin = Tracer::lap("edges", traceBegin, iteration);)
 
             barrier.await();
+            INSTRUMENT(report.addBarrierWait(index, timer.lap());)
+            TRACE(traceBegin = Tracer::lap("barrier", traceBegin, iteration);)
 
-            // Update previousPageHashMap.
-            // FIXME maybe too slow, maybe can copy
-            for (uint64_t i = index * pageSegment; i < (index + 1) * pageSegment && i < pages.size(); ++i)
-                previousPageHashMap[pages[i]] = pageHashMap[pages[i]].load();
+            // Update previousPageRanks.
+            for (PageIndex v = pagesBegin; v < pagesEnd; ++v)
+                previousPageRanks[v] = pageRanks[v];
+            INSTRUMENT(report.addPhase(index, RunReport::copy, timer.lap());)
+            TRACE(traceBegin = Tracer::lap("copy", traceBegin, iteration);)
 
             barrier.await();
+            INSTRUMENT(report.addBarrierWait(index, timer.lap());)
+            TRACE(traceBegin = Tracer::lap("barrier", traceBegin, iteration++);)
         }
     }
 };
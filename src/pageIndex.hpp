@@ -0,0 +1,10 @@
+#ifndef SRC_PAGEINDEX_HPP_
+#define SRC_PAGEINDEX_HPP_
+
+#include <cstdint>
+
+// Compact handle of a page of a prepared network, pages of the network get
+// [0, network.getSize()) in their order. Equality and hashing are integer ones.
+typedef uint32_t PageIndex;
+
+#endif /* SRC_PAGEINDEX_HPP_ */
@@ -0,0 +1,106 @@
+#ifndef SRC_PARALLELUTILS_HPP_
+#define SRC_PARALLELUTILS_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Taken from labs, also featured in Meyers' C++ book.
+// Safe thread creation and freeing.
+class ThreadRAII {
+public:
+    enum class DtorAction { join,
+        detach };
+
+    ThreadRAII(std::thread&& t, DtorAction a)
+        : action(a)
+        , t(std::move(t))
+    {
+    }
+    ThreadRAII(ThreadRAII&& t)
+        : action(t.action)
+        , t(std::move(t.get()))
+    {
+    }
+    ~ThreadRAII()
+    {
+        if (t.joinable()) {
+            if (action == DtorAction::join)
+                t.join();
+            else
+                t.detach();
+        }
+    }
+
+    std::thread& get() { return t; }
+
+private:
+    DtorAction action;
+    std::thread t;
+};
+
+// Runs func(index) for every index in [0, numThreads) and returns when all
+// of them are done. A single index runs on the calling thread, there is no
+// point in paying for a thread which would be joined right away.
+template <typename Func>
+void runInParallel(uint32_t numThreads, Func const& func)
+{
+    if (numThreads == 1) {
+        func(0);
+        return;
+    }
+
+    std::vector<ThreadRAII> threads;
+    threads.reserve(numThreads);
+    for (uint32_t i = 0; i < numThreads; ++i)
+        threads.push_back({ std::thread { [&func, i] { func(i); } },
+            ThreadRAII::DtorAction::join });
+}
+
+// Reusable barrier for a fixed group of threads.
+class Barrier {
+public:
+    Barrier(uint32_t partiesArg)
+        : parties(partiesArg)
+        , waiting(0)
+        , generation(0)
+    {
+    }
+
+    void await()
+    {
+        std::unique_lock<std::mutex> lock(mut);
+        auto myGeneration = generation;
+        if (++waiting == parties) {
+            waiting = 0;
+            ++generation;
+            cond.notify_all();
+            return;
+        }
+        cond.wait(lock, [this, myGeneration] { return generation != myGeneration; });
+    }
+
+private:
+    uint32_t parties;
+    uint32_t waiting;
+    uint64_t generation;
+
+    std::mutex mut;
+    std::condition_variable cond;
+};
+
+// Bounds of the index-th out of numParts contiguous, almost equal segments of [0, size).
+inline size_t segmentBegin(size_t size, uint32_t numParts, uint32_t index)
+{
+    return size / numParts * index + std::min<size_t>(index, size % numParts);
+}
+
+inline size_t segmentEnd(size_t size, uint32_t numParts, uint32_t index)
+{
+    return segmentBegin(size, numParts, index + 1);
+}
+
+#endif /* SRC_PARALLELUTILS_HPP_ */
@@ -0,0 +1,124 @@
+#ifndef SRC_PERSONALIZEDPAGERANKCOMPUTER_HPP_
+#define SRC_PERSONALIZEDPAGERANKCOMPUTER_HPP_
+
+#include <deque>
+#include <vector>
+
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+#include "blockPowerIteration.hpp"
+#include "preparedGraph.hpp"
+
+// PageRank with the teleport vector concentrated on a seed set of pages.
+// Teleports, and the weight of dangling pages, jump uniformly to the seeds of
+// the query (the networkx convention). With all pages as seeds this is plain
+// PageRank.
+class PersonalizedPageRankComputer {
+public:
+    PersonalizedPageRankComputer(uint32_t numThreadsArg)
+        : numThreads(numThreadsArg) {};
+
+    // Answers every seed set at once as one block of BlockPowerIteration, so
+    // each edge is read once per iteration for all of them. One full result
+    // per seed set.
+    std::vector<std::vector<PageIdAndRank>> computeForSeeds(Network const& network, std::vector<std::vector<PageId>> const& seedSets, double alpha, uint32_t iterations, double tolerance) const
+    {
+        PreparedGraph graph(network, numThreads);
+        return computeForSeeds(graph, seedSets, alpha, iterations, tolerance);
+    }
+
+    std::vector<std::vector<PageIdAndRank>> computeForSeeds(PreparedGraph const& graph, std::vector<std::vector<PageId>> const& seedSets, double alpha, uint32_t iterations, double tolerance) const
+    {
+        size_t numQueries = seedSets.size();
+        size_t networkSize = graph.getSize();
+
+        // teleport[v * numQueries + q] is the jump probability to v in query q.
+        std::vector<double> teleport(networkSize * numQueries, 0);
+        for (size_t q = 0; q < numQueries; ++q) {
+            ASSERT(not seedSets[q].empty(), "Empty seed set for query=" << q);
+            for (auto const& seed : seedSets[q]) {
+                PageIndex seedIndex;
+                ASSERT(graph.findIndex(seed, seedIndex), "Seed outside of the network=" << seed);
+                teleport[seedIndex * numQueries + q] += 1.0 / seedSets[q].size();
+            }
+        }
+
+        std::vector<PageRankParameters> parameters(numQueries, PageRankParameters { alpha, tolerance });
+        std::vector<PageRank> pageRanks = BlockPowerIteration::run(graph, numThreads, parameters, teleport, iterations);
+        ASSERT(not pageRanks.empty(), "Not able to find result in iterations=" << iterations);
+
+        std::vector<std::vector<PageIdAndRank>> results;
+        for (size_t q = 0; q < numQueries; ++q)
+            results.push_back(BlockPowerIteration::materialize(graph, pageRanks, numQueries, q));
+        return results;
+    }
+
+    // Approximate single seed query by forward push (Andersen, Chung, Lang).
+    // Only touches pages around the seed once the graph is set up. Pages end
+    // with residual below epsilon per out-link, ranks are underestimated by
+    // at most that much. Only pages with a nonzero estimate are returned.
+    std::vector<PageIdAndRank> computeForwardPush(Network const& network, PageId const& seed, double alpha, double epsilon) const
+    {
+        PreparedGraph graph(network, numThreads);
+        return computeForwardPush(graph, graph.getEdges().transposed(numThreads), seed, alpha, epsilon);
+    }
+
+    // The same with the graph and its out-links (graph.getEdges().transposed())
+    // set up beforehand, so a query only costs the pushes.
+    std::vector<PageIdAndRank> computeForwardPush(PreparedGraph const& graph, CsrGraph const& outLinks, PageId const& seed, double alpha, double epsilon) const
+    {
+        auto const& numLinks = graph.getNumLinks();
+        auto const& offsets = outLinks.getOffsets();
+        auto const& targets = outLinks.getSources();
+
+        PageIndex seedIndex;
+        ASSERT(graph.findIndex(seed, seedIndex), "Seed outside of the network=" << seed);
+
+        std::vector<PageRank> estimate(graph.getSize(), 0), residual(graph.getSize(), 0);
+        std::vector<bool> queued(graph.getSize(), false);
+        std::deque<PageIndex> queue;
+
+        auto pushTo = [&](PageIndex v, double mass) {
+            residual[v] += mass;
+            if (not queued[v] && residual[v] > epsilon * std::max<uint32_t>(numLinks[v], 1)) {
+                queued[v] = true;
+                queue.push_back(v);
+            }
+        };
+
+        pushTo(seedIndex, 1.0);
+        while (not queue.empty()) {
+            PageIndex u = queue.front();
+            queue.pop_front();
+            queued[u] = false;
+
+            double mass = residual[u];
+            residual[u] = 0;
+            estimate[u] += (1.0 - alpha) * mass;
+
+            if (numLinks[u] == 0) {
+                pushTo(seedIndex, alpha * mass);
+                continue;
+            }
+            // Links leaving the network take their share with them.
+            for (uint64_t e = offsets[u]; e < offsets[u + 1]; ++e)
+                pushTo(targets[e], alpha * mass / numLinks[u]);
+        }
+
+        std::vector<PageIdAndRank> result;
+        for (PageIndex v = 0; v < graph.getSize(); ++v)
+            if (estimate[v] > 0)
+                result.push_back(PageIdAndRank(graph.getId(v), estimate[v]));
+        return result;
+    }
+
+    std::string getName() const
+    {
+        return "PersonalizedPageRankComputer[" + std::to_string(this->numThreads) + "]";
+    }
+
+private:
+    uint32_t numThreads;
+};
+
+#endif /* SRC_PERSONALIZEDPAGERANKCOMPUTER_HPP_ */
@@ -0,0 +1,305 @@
+#ifndef SRC_PREPAREDGRAPH_HPP_
+#define SRC_PREPAREDGRAPH_HPP_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "immutable/common.hpp"
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+#include "compressedCsrGraph.hpp"
+#include "concurrentPageIdMap.hpp"
+#include "csrGraph.hpp"
+#include "instrumentation.hpp"
+#include "parallelUtils.hpp"
+#include "topKSelector.hpp"
+#include "tracer.hpp"
+
+// The network with page ids generated and links resolved to page indices,
+// built once and shared by any number of runs of any PageRankComputer.
+// Pages get handles [0, network.getSize()) in the order of the network.
+//
+// Ids already generated for a page (by an earlier PreparedGraph of the same
+// network) are reused, so a network can be prepared more than once, also by
+// several threads at the same time.
+//
+// The in-links can be compressed once after preparing, which drops the plain
+// ones. Such a graph still runs with any PageRankComputer: kernels reading
+// getCompressedEdges() use the compressed in-links, the others get the plain
+// ones decoded again on first use.
+class PreparedGraph {
+public:
+    PreparedGraph(Network const& network, uint32_t numThreads)
+        : pageIndices(network.getSize())
+        , numLinks(network.getSize())
+        , danglingNodes()
+        , edges()
+        , decoded()
+        , compressedEdges()
+        , numEdges(0)
+        , fingerprint(0)
+        , idGenerationSeconds(0)
+        , setupSeconds(0)
+    {
+        INSTRUMENT(PhaseTimer setupTimer;)
+        INSTRUMENT(std::vector<double> threadIdGenerationSeconds(numThreads, 0);)
+        std::vector<std::vector<PageIndex>> threadDanglingNodes(numThreads);
+        CsrGraphBuilder builder(network.getSize(), numThreads);
+        // Links whose target was not registered yet when their page was set up.
+        std::vector<std::vector<std::pair<PageIndex, PageId const*>>> pendingLinks(numThreads);
+
+        // Pipelined setup: every thread takes batches of pages, generates their
+        // ids, registers them and buckets the links it can already resolve, so
+        // hashing overlaps with indexing and edge bucketing.
+        std::atomic<size_t> frst_free { 0 };
+        runInParallel(numThreads, [&](uint32_t thread) {
+            TRACE(uint64_t traceBegin = Tracer::now();)
+            while (true) {
+                auto batchBegin = frst_free.fetch_add(batchSize);
+                if (batchBegin >= network.getSize())
+                    break;
+                auto batchEnd = std::min(network.getSize(), batchBegin + batchSize);
+
+                INSTRUMENT(PhaseTimer idGenerationTimer;)
+                for (auto page_idx = batchBegin; page_idx < batchEnd; ++page_idx) {
+                    auto const& page = network.getPages()[page_idx];
+                    page.ensureId(network.getGenerator());
+                    ASSERT(pageIndices.insert(page_idx, page.getId()) == page_idx, "Duplicate page id=" << page.getId());
+                }
+                INSTRUMENT(threadIdGenerationSeconds[thread] += idGenerationTimer.lap();)
+
+                for (auto page_idx = batchBegin; page_idx < batchEnd; ++page_idx) {
+                    auto const& page_links = network.getPages()[page_idx].getLinks();
+                    numLinks[page_idx] = page_links.size();
+                    if (page_links.empty())
+                        threadDanglingNodes[thread].push_back(page_idx);
+                    for (auto const& link : page_links) {
+                        PageIndex target;
+                        if (pageIndices.find(link, target))
+                            builder.addEdge(thread, page_idx, target);
+                        else
+                            pendingLinks[thread].push_back({ page_idx, &link });
+                    }
+                }
+            }
+            TRACE(Tracer::lap("setup", traceBegin);)
+        });
+
+        // All ids are registered now, links still unknown leave the network
+        // and only count towards numLinks.
+        runInParallel(numThreads, [&](uint32_t thread) {
+            TRACE(uint64_t traceBegin = Tracer::now();)
+            for (auto const& pending : pendingLinks[thread]) {
+                PageIndex target;
+                if (pageIndices.find(*pending.second, target))
+                    builder.addEdge(thread, pending.first, target);
+            }
+            TRACE(Tracer::lap("pendingLinks", traceBegin);)
+        });
+
+        for (auto const& nodes : threadDanglingNodes)
+            danglingNodes.insert(danglingNodes.end(), nodes.begin(), nodes.end());
+
+        TRACE(uint64_t traceBegin = Tracer::now();)
+        edges = builder.build();
+        numEdges = edges.getNumEdges();
+        fingerprint = fingerprintOf(numLinks, edges);
+        TRACE(Tracer::lap("buildEdges", traceBegin);)
+
+        INSTRUMENT(for (auto seconds : threadIdGenerationSeconds) idGenerationSeconds += seconds;)
+        INSTRUMENT(setupSeconds = setupTimer.lap();)
+    }
+
+    // A graph which never was a Network, e.g. a generated one: page i has id
+    // ids[i], numLinksArg[i] out-links and the in-links of edgesArg.
+    PreparedGraph(std::vector<PageId> const& ids, std::vector<uint32_t> numLinksArg, CsrGraph edgesArg, uint32_t numThreads)
+        : pageIndices(ids.size())
+        , numLinks(std::move(numLinksArg))
+        , danglingNodes()
+        , edges(std::move(edgesArg))
+        , decoded()
+        , compressedEdges()
+        , numEdges(edges.getNumEdges())
+        , fingerprint(fingerprintOf(numLinks, edges))
+        , idGenerationSeconds(0)
+        , setupSeconds(0)
+    {
+        ASSERT(numLinks.size() == ids.size() && edges.getSize() == ids.size(),
+            "Inconsistent graph, ids=" << ids.size() << ", numLinks=" << numLinks.size() << ", edges=" << edges.getSize());
+
+        INSTRUMENT(PhaseTimer setupTimer;)
+        std::vector<std::vector<PageIndex>> threadDanglingNodes(numThreads);
+        runInParallel(numThreads, [&](uint32_t thread) {
+            auto end = segmentEnd(ids.size(), numThreads, thread);
+            for (auto page_idx = segmentBegin(ids.size(), numThreads, thread); page_idx < end; ++page_idx) {
+                ASSERT(pageIndices.insert(page_idx, ids[page_idx]) == page_idx, "Duplicate page id=" << ids[page_idx]);
+                if (numLinks[page_idx] == 0)
+                    threadDanglingNodes[thread].push_back(page_idx);
+            }
+        });
+
+        for (auto const& nodes : threadDanglingNodes)
+            danglingNodes.insert(danglingNodes.end(), nodes.begin(), nodes.end());
+
+        INSTRUMENT(setupSeconds = setupTimer.lap();)
+    }
+
+    PreparedGraph(PreparedGraph const&) = delete;
+    PreparedGraph& operator=(PreparedGraph const&) = delete;
+
+    size_t getSize() const
+    {
+        return this->numLinks.size();
+    }
+
+    PageId const& getId(PageIndex index) const
+    {
+        return this->pageIndices.getId(index);
+    }
+
+    bool findIndex(PageId const& pageId, PageIndex& index) const
+    {
+        return this->pageIndices.find(pageId, index);
+    }
+
+    // Out-degree of every page, links leaving the network included.
+    std::vector<uint32_t> const& getNumLinks() const
+    {
+        return this->numLinks;
+    }
+
+    std::vector<PageIndex> const& getDanglingNodes() const
+    {
+        return this->danglingNodes;
+    }
+
+    // getEdges().getSources()[getEdges().getOffsets()[b]...] are all a such that a -> b.
+    // Of a compressed graph they are decoded once, by the first caller, with
+    // every row sorted, and take their memory again.
+    CsrGraph const& getEdges() const
+    {
+        if (this->hasCompressedEdges())
+            std::call_once(this->decoded, [this] { this->decodeEdges(); });
+        return this->edges;
+    }
+
+    // In-links within the network, with either layout.
+    uint64_t getNumEdges() const
+    {
+        return this->numEdges;
+    }
+
+    // Hash of the out-degrees and in-degrees of all pages, telling graphs of
+    // the same size apart, e.g. for checkpoints.
+    uint64_t getFingerprint() const
+    {
+        return this->fingerprint;
+    }
+
+    // Replaces the in-links by a CompressedCsrGraph of them, encoded by
+    // numThreads threads. Not to be called while the graph is being run.
+    void compressEdges(uint32_t numThreads)
+    {
+        ASSERT(not this->hasCompressedEdges(), "Compressing in-links twice");
+        TRACE(uint64_t traceBegin = Tracer::now();)
+        this->compressedEdges.reset(new CompressedCsrGraph(this->edges, numThreads));
+        this->edges = CsrGraph();
+        TRACE(Tracer::lap("compressEdges", traceBegin);)
+    }
+
+    bool hasCompressedEdges() const
+    {
+        return this->compressedEdges != nullptr;
+    }
+
+    CompressedCsrGraph const& getCompressedEdges() const
+    {
+        ASSERT(this->hasCompressedEdges(), "In-links not compressed");
+        return *this->compressedEdges;
+    }
+
+    // Id generation (with registering the ids) summed over the setup threads,
+    // and the wall time of the whole setup. Only measured when built with
+    // instrumentation, 0 otherwise.
+    double getIdGenerationSeconds() const
+    {
+        return this->idGenerationSeconds;
+    }
+
+    double getSetupSeconds() const
+    {
+        return this->setupSeconds;
+    }
+
+    // Ranks indexed by page index as a full result.
+    std::vector<PageIdAndRank> toResult(std::vector<PageRank> const& pageRanks) const
+    {
+        std::vector<PageIdAndRank> result;
+        result.reserve(pageRanks.size());
+        for (PageIndex page_idx = 0; page_idx < pageRanks.size(); ++page_idx)
+            result.push_back(PageIdAndRank(this->getId(page_idx), pageRanks[page_idx]));
+
+        ASSERT(result.size() == this->getSize(), "Invalid result size=" << result.size() << ", for graph of size=" << this->getSize());
+
+        return result;
+    }
+
+    // Only the k pages with the highest rank, from the highest.
+    std::vector<PageIdAndRank> toTopKResult(std::vector<PageRank> const& pageRanks, uint32_t k, uint32_t numThreads) const
+    {
+        std::vector<PageIdAndRank> result;
+        for (auto page_idx : TopKSelector::select(pageRanks, k, numThreads))
+            result.push_back(PageIdAndRank(this->getId(page_idx), pageRanks[page_idx]));
+        return result;
+    }
+
+private:
+    // Pages a thread takes at once during setup.
+    static constexpr size_t batchSize = 64;
+
+    void decodeEdges() const
+    {
+        TRACE(uint64_t traceBegin = Tracer::now();)
+        std::vector<uint64_t> offsets(1, 0);
+        std::vector<PageIndex> sources;
+        offsets.reserve(this->getSize() + 1);
+        sources.reserve(this->numEdges);
+        for (PageIndex v = 0; v < this->getSize(); ++v) {
+            this->compressedEdges->forEachSource(v, [&](PageIndex source) { sources.push_back(source); });
+            offsets.push_back(sources.size());
+        }
+        this->edges = CsrGraph(std::move(offsets), std::move(sources));
+        TRACE(Tracer::lap("decodeEdges", traceBegin);)
+    }
+
+    // FNV-1a over the out-degrees and the in-link offsets.
+    static uint64_t fingerprintOf(std::vector<uint32_t> const& numLinks, CsrGraph const& edges)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&hash](uint64_t value) {
+            hash ^= value;
+            hash *= 1099511628211ULL;
+        };
+        for (auto count : numLinks)
+            mix(count);
+        for (auto offset : edges.getOffsets())
+            mix(offset);
+        return hash;
+    }
+
+    ConcurrentPageIdMap pageIndices;
+    std::vector<uint32_t> numLinks;
+    std::vector<PageIndex> danglingNodes;
+    // Decoded from compressedEdges by getEdges() when compressed.
+    mutable CsrGraph edges;
+    mutable std::once_flag decoded;
+    std::unique_ptr<CompressedCsrGraph> compressedEdges;
+    uint64_t numEdges;
+    uint64_t fingerprint;
+    double idGenerationSeconds;
+    double setupSeconds;
+};
+
+#endif /* SRC_PREPAREDGRAPH_HPP_ */
@@ -0,0 +1,198 @@
+#ifndef SRC_PRESOLVEDGRAPH_HPP_
+#define SRC_PRESOLVEDGRAPH_HPP_
+
+#include <algorithm>
+#include <vector>
+
+#include "immutable/common.hpp"
+#include "csrGraph.hpp"
+#include "pageIndex.hpp"
+#include "parallelUtils.hpp"
+#include "preparedGraph.hpp"
+
+// The pages of a PreparedGraph split by how LumpedPageRankComputer finds
+// their ranks:
+// - upstream pages only have in-links from upstream pages (pages without
+//   in-links and chains hanging off them), so their ranks follow from their
+//   in-links in topological order, before any iteration,
+// - downstream pages only link to downstream pages or out of the network
+//   (dangling pages and chains leading to them), so no other page depends on
+//   them and their ranks follow from their in-links once the core is solved,
+// - the core pages are everything else, whose ranks have to be iterated.
+//
+// Both peeled parts come in layers, a page only depending on pages of
+// earlier layers, so every layer can be solved in parallel. Upstream layers
+// are found with a pass over the pages each, so deep upstream chains are cut
+// short, downstream ones are peeled off completely. Without peeling there
+// are no upstream pages and only the pages without links within the network
+// are downstream, in a single layer.
+class PresolvedGraph {
+public:
+    // Upstream layers are peeled off while they have at least one in
+    // minLayerShare pages.
+    static constexpr uint32_t minLayerShare = 256;
+
+    enum class Part : uint8_t { upstream,
+        core,
+        downstream };
+
+    PresolvedGraph(PreparedGraph const& graph, uint32_t numThreads, bool peel = true)
+        : parts(graph.getSize(), Part::core)
+        , numNetworkLinks(graph.getSize(), 0)
+        , upstream()
+        , upstreamLayers(1, 0)
+        , downstream()
+        , downstreamLayers(1, 0)
+        , corePages()
+        , coreIndex()
+        , coreEdges()
+    {
+        size_t size = graph.getSize();
+        auto const& edges = graph.getEdges();
+
+        if (peel) {
+            // Layer by layer, the pages whose in-links all come from earlier
+            // layers. Every layer takes a pass over the pages, so this stops
+            // after a layer of less than one in minLayerShare pages, leaving
+            // the pages further down to the core and downstream.
+            size_t minLayer = std::max<size_t>(1, size / minLayerShare);
+            auto const& sources = edges.getSources();
+            std::vector<std::vector<PageIndex>> found(numThreads);
+            while (true) {
+                runInParallel(numThreads, [&](uint32_t thread) {
+                    found[thread].clear();
+                    auto end = segmentEnd(size, numThreads, thread);
+                    for (auto v = segmentBegin(size, numThreads, thread); v < end; ++v) {
+                        if (this->parts[v] != Part::core)
+                            continue;
+                        uint64_t e = edges.getOffsets()[v];
+                        while (e < edges.getOffsets()[v + 1] && this->parts[sources[e]] == Part::upstream)
+                            ++e;
+                        if (e == edges.getOffsets()[v + 1])
+                            found[thread].push_back(v);
+                    }
+                });
+                size_t layerBegin = this->upstream.size();
+                for (auto const& pages : found)
+                    this->upstream.insert(this->upstream.end(), pages.begin(), pages.end());
+                if (this->upstream.size() == layerBegin)
+                    break;
+                for (size_t i = layerBegin; i < this->upstream.size(); ++i)
+                    this->parts[this->upstream[i]] = Part::upstream;
+                this->upstreamLayers.push_back(this->upstream.size());
+                if (this->upstream.size() - layerBegin < minLayer)
+                    break;
+            }
+        }
+
+        // In-links of upstream pages come from upstream pages only, so the
+        // links of the other pages stay among them.
+        for (PageIndex v = 0; v < size; ++v)
+            edges.forEachSource(v, [&](PageIndex source) { ++this->numNetworkLinks[source]; });
+        std::vector<uint32_t> pendingLinks = this->numNetworkLinks;
+        for (PageIndex v = 0; v < size; ++v) {
+            if (pendingLinks[v] == 0 && this->parts[v] != Part::upstream)
+                this->downstream.push_back(v);
+        }
+        addLayers(this->downstream, this->downstreamLayers, [&](PageIndex v, std::vector<PageIndex>& next) {
+            if (not peel)
+                return;
+            edges.forEachSource(v, [&](PageIndex source) {
+                if (this->parts[source] != Part::upstream && --pendingLinks[source] == 0)
+                    next.push_back(source);
+            });
+        });
+        for (auto v : this->downstream)
+            this->parts[v] = Part::downstream;
+
+        for (PageIndex v = 0; v < size; ++v) {
+            if (this->parts[v] == Part::core)
+                this->corePages.push_back(v);
+        }
+        size_t numCore = this->corePages.size();
+        this->coreIndex.assign(size, numCore);
+        for (PageIndex u = 0; u < numCore; ++u)
+            this->coreIndex[this->corePages[u]] = u;
+        this->coreEdges = edges.induced(this->corePages, this->coreIndex, numThreads);
+    }
+
+    std::vector<Part> const& getParts() const
+    {
+        return this->parts;
+    }
+
+    // Links of every page to pages of the network, unlike
+    // PreparedGraph::getNumLinks() without links leaving it.
+    std::vector<uint32_t> const& getNumNetworkLinks() const
+    {
+        return this->numNetworkLinks;
+    }
+
+    // Layer i is getUpstream()[getUpstreamLayers()[i]], ..., getUpstream()[getUpstreamLayers()[i + 1] - 1].
+    std::vector<PageIndex> const& getUpstream() const
+    {
+        return this->upstream;
+    }
+
+    std::vector<size_t> const& getUpstreamLayers() const
+    {
+        return this->upstreamLayers;
+    }
+
+    // Layers as for getUpstream(), layer 0 being the pages without links within the network.
+    std::vector<PageIndex> const& getDownstream() const
+    {
+        return this->downstream;
+    }
+
+    std::vector<size_t> const& getDownstreamLayers() const
+    {
+        return this->downstreamLayers;
+    }
+
+    // Core pages numbered compactly, in the order of their pages.
+    std::vector<PageIndex> const& getCorePages() const
+    {
+        return this->corePages;
+    }
+
+    // getCorePages().size() for the other pages.
+    std::vector<PageIndex> const& getCoreIndex() const
+    {
+        return this->coreIndex;
+    }
+
+    // In-links among core pages, by their compact numbers.
+    CsrGraph const& getCoreEdges() const
+    {
+        return this->coreEdges;
+    }
+
+private:
+    std::vector<Part> parts;
+    std::vector<uint32_t> numNetworkLinks;
+    std::vector<PageIndex> upstream;
+    std::vector<size_t> upstreamLayers;
+    std::vector<PageIndex> downstream;
+    std::vector<size_t> downstreamLayers;
+    std::vector<PageIndex> corePages;
+    std::vector<PageIndex> coreIndex;
+    CsrGraph coreEdges;
+
+    // `pages` holds the first layer, visit(v, next) appends the pages v
+    // completes to `next` until no more pages are completed.
+    template <typename Visit>
+    static void addLayers(std::vector<PageIndex>& pages, std::vector<size_t>& layers, Visit const& visit)
+    {
+        std::vector<PageIndex> next;
+        while (layers.back() < pages.size()) {
+            next.clear();
+            for (size_t i = layers.back(); i < pages.size(); ++i)
+                visit(pages[i], next);
+            layers.push_back(pages.size());
+            pages.insert(pages.end(), next.begin(), next.end());
+        }
+    }
+};
+
+#endif /* SRC_PRESOLVEDGRAPH_HPP_ */
@@ -0,0 +1,262 @@
+#ifndef SRC_PROCESSGROUP_HPP_
+#define SRC_PROCESSGROUP_HPP_
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "immutable/common.hpp"
+
+// Builds a message of varint encoded integers (7 bits per byte, low groups
+// first, as in protobuf) and raw doubles.
+class MessageWriter {
+public:
+    void putVarint(uint64_t value)
+    {
+        while (value >= 0x80) {
+            this->data.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        this->data.push_back(static_cast<char>(value));
+    }
+
+    void putDouble(double value)
+    {
+        char bytes[sizeof(double)];
+        std::memcpy(bytes, &value, sizeof(double));
+        this->data.append(bytes, sizeof(double));
+    }
+
+    std::string& getData()
+    {
+        return this->data;
+    }
+
+private:
+    std::string data;
+};
+
+// Reads a message built by MessageWriter, in the same order.
+class MessageReader {
+public:
+    MessageReader(std::string const& dataArg)
+        : data(dataArg)
+        , position(0)
+    {
+    }
+
+    uint64_t getVarint()
+    {
+        uint64_t value = 0;
+        for (uint32_t shift = 0;; shift += 7) {
+            ASSERT(this->position < this->data.size(), "Truncated message");
+            auto byte = static_cast<unsigned char>(this->data[this->position++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (byte < 0x80)
+                return value;
+        }
+    }
+
+    double getDouble()
+    {
+        ASSERT(this->position + sizeof(double) <= this->data.size(), "Truncated message");
+        double value;
+        std::memcpy(&value, this->data.data() + this->position, sizeof(double));
+        this->position += sizeof(double);
+        return value;
+    }
+
+    bool atEnd() const
+    {
+        return this->position == this->data.size();
+    }
+
+private:
+    std::string const& data;
+    size_t position;
+};
+
+// Local processes numbered [0, size) and connected pairwise by Unix domain
+// sockets, the message passing layer of DistributedPageRankComputer. Every
+// process sees the memory of the caller as it was at run(), so read only
+// inputs need no transfer.
+class ProcessGroup {
+public:
+    ProcessGroup(ProcessGroup const&) = delete;
+    ProcessGroup& operator=(ProcessGroup const&) = delete;
+
+    ~ProcessGroup()
+    {
+        for (auto socket : this->sockets)
+            if (socket >= 0)
+                close(socket);
+    }
+
+    uint32_t getRank() const
+    {
+        return this->rank;
+    }
+
+    uint32_t getSize() const
+    {
+        return this->sockets.size();
+    }
+
+    // Sends outgoing[q] to every other process q and returns what each of
+    // them sent here, incoming[getRank()] stays empty. Like MPI_Alltoall all
+    // processes call it the same number of times. Sends and receives are
+    // interleaved with poll(), so no process blocks on a full socket while
+    // its peer does the same.
+    std::vector<std::string> exchange(std::vector<std::string> const& outgoing)
+    {
+        ASSERT(outgoing.size() == this->getSize(), "Invalid number of messages=" << outgoing.size());
+
+        // Every message goes as its length followed by the payload.
+        std::vector<std::string> frames(this->getSize());
+        std::vector<std::string> incoming(this->getSize());
+        std::vector<size_t> sent(this->getSize(), 0), received(this->getSize(), 0);
+        std::vector<uint64_t> lengths(this->getSize(), 0);
+        for (uint32_t q = 0; q < this->getSize(); ++q) {
+            if (q == this->rank)
+                continue;
+            uint64_t length = outgoing[q].size();
+            frames[q].append(reinterpret_cast<char const*>(&length), sizeof(length));
+            frames[q].append(outgoing[q]);
+        }
+
+        std::vector<pollfd> fds;
+        std::vector<uint32_t> peers;
+        while (true) {
+            fds.clear();
+            peers.clear();
+            for (uint32_t q = 0; q < this->getSize(); ++q) {
+                if (q == this->rank)
+                    continue;
+                short events = 0;
+                if (sent[q] < frames[q].size())
+                    events |= POLLOUT;
+                if (received[q] < sizeof(uint64_t) + lengths[q])
+                    events |= POLLIN;
+                if (events != 0) {
+                    fds.push_back({ this->sockets[q], events, 0 });
+                    peers.push_back(q);
+                }
+            }
+            if (fds.empty())
+                return incoming;
+
+            int ready = poll(fds.data(), fds.size(), -1);
+            if (ready < 0 && errno == EINTR)
+                continue;
+            ASSERT(ready > 0, "poll failed");
+
+            for (size_t f = 0; f < fds.size(); ++f) {
+                uint32_t q = peers[f];
+                if (fds[f].revents & POLLOUT) {
+                    ssize_t count = send(fds[f].fd, frames[q].data() + sent[q], frames[q].size() - sent[q], MSG_DONTWAIT | MSG_NOSIGNAL);
+                    ASSERT(count > 0 || errno == EAGAIN || errno == EINTR, "Sending to process=" << q << " failed");
+                    if (count > 0)
+                        sent[q] += count;
+                }
+                if (fds[f].revents & (POLLIN | POLLHUP | POLLERR))
+                    this->receive(q, fds[f].fd, received[q], lengths[q], incoming[q]);
+            }
+        }
+    }
+
+    // Runs func(group) in numProcesses processes, the calling one being rank
+    // 0, and returns once all of them finished. Other processes are forked,
+    // so the caller should not have other threads running; they leave with
+    // _exit() right after func.
+    template <typename Func>
+    static void run(uint32_t numProcesses, Func const& func)
+    {
+        ASSERT(numProcesses > 0, "ProcessGroup needs at least one process");
+
+        // sockets[p][q] is the end of process p of its connection to q.
+        std::vector<std::vector<int>> sockets(numProcesses, std::vector<int>(numProcesses, -1));
+        for (uint32_t p = 0; p < numProcesses; ++p) {
+            for (uint32_t q = p + 1; q < numProcesses; ++q) {
+                int pair[2];
+                ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0, "socketpair failed");
+                sockets[p][q] = pair[0];
+                sockets[q][p] = pair[1];
+            }
+        }
+
+        std::vector<pid_t> children;
+        for (uint32_t rank = 1; rank < numProcesses; ++rank) {
+            pid_t pid = fork();
+            ASSERT(pid >= 0, "fork failed");
+            if (pid == 0) {
+                closeAllBut(sockets, rank);
+                {
+                    ProcessGroup group(rank, sockets[rank]);
+                    func(group);
+                }
+                _exit(0);
+            }
+            children.push_back(pid);
+        }
+
+        closeAllBut(sockets, 0);
+        {
+            ProcessGroup group(0, sockets[0]);
+            func(group);
+        }
+
+        for (auto pid : children) {
+            int status;
+            ASSERT(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+                "Process of the group failed, pid=" << pid);
+        }
+    }
+
+private:
+    uint32_t rank;
+    // Connection to every process, -1 for this one.
+    std::vector<int> sockets;
+
+    ProcessGroup(uint32_t rankArg, std::vector<int> const& socketsArg)
+        : rank(rankArg)
+        , sockets(socketsArg)
+    {
+    }
+
+    // Reads what is available of the frame from process q.
+    static void receive(uint32_t q, int fd, size_t& received, uint64_t& length, std::string& message)
+    {
+        ssize_t count;
+        if (received < sizeof(uint64_t)) {
+            count = recv(fd, reinterpret_cast<char*>(&length) + received, sizeof(uint64_t) - received, MSG_DONTWAIT);
+        } else {
+            count = recv(fd, &message[received - sizeof(uint64_t)], sizeof(uint64_t) + length - received, MSG_DONTWAIT);
+        }
+        ASSERT(count != 0, "Process=" << q << " ended during an exchange");
+        ASSERT(count > 0 || errno == EAGAIN || errno == EINTR, "Receiving from process=" << q << " failed");
+        if (count < 0)
+            return;
+
+        received += count;
+        if (received == sizeof(uint64_t))
+            message.resize(length);
+    }
+
+    // Closes the ends of the connections which do not belong to process `rank`.
+    static void closeAllBut(std::vector<std::vector<int>>& sockets, uint32_t rank)
+    {
+        for (uint32_t p = 0; p < sockets.size(); ++p)
+            if (p != rank)
+                for (auto& socket : sockets[p])
+                    if (socket >= 0)
+                        close(socket);
+    }
+};
+
+#endif /* SRC_PROCESSGROUP_HPP_ */
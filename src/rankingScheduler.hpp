@@ -0,0 +1,347 @@
+#ifndef SRC_RANKINGSCHEDULER_HPP_
+#define SRC_RANKINGSCHEDULER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "immutable/common.hpp"
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+#include "parallelUtils.hpp"
+#include "preparedGraph.hpp"
+#include "runBudget.hpp"
+
+// Runs many rankings at once on one pool of threads, so concurrent jobs
+// share the cores instead of each starting threads of its own.
+//
+// A job iterates like MultiThreadedPageRankComputer, but an iteration is a
+// set of tasks over balanced page segments instead of a phase of fixed
+// threads, and the task finishing an iteration last combines the partial
+// sums and queues the next one. Jobs with less than minTaskWork pages and
+// in-links run one task per iteration, i.e. single-threaded, larger ones get
+// a task per minTaskWork, at most one per thread.
+//
+// Free threads take a task of the highest priority with tasks queued, jobs of
+// the same priority take turns task by task.
+//
+// Jobs of the same Network share one PreparedGraph, prepared by a task of the
+// first of them while the others wait, and kept until the last one is done.
+class RankingScheduler {
+public:
+    static constexpr uint64_t minTaskWork = 1 << 15;
+
+    RankingScheduler(uint32_t numThreadsArg)
+        : numThreads(numThreadsArg)
+        , stopping(false)
+        , numActiveJobs(0)
+        , queued()
+        , preparations()
+        , threads()
+    {
+        ASSERT(numThreadsArg > 0, "Invalid numThreads=" << numThreadsArg);
+        this->threads.reserve(numThreadsArg);
+        for (uint32_t i = 0; i < numThreadsArg; ++i)
+            this->threads.push_back({ std::thread { [this] { this->workLoop(); } }, ThreadRAII::DtorAction::join });
+    }
+
+    RankingScheduler(RankingScheduler const&) = delete;
+    RankingScheduler& operator=(RankingScheduler const&) = delete;
+
+    // Finishes all submitted jobs first.
+    ~RankingScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mut);
+            this->stopping = true;
+        }
+        this->cond.notify_all();
+        this->threads.clear();
+    }
+
+    // Stops once converged or after `iterations`, see BestEffortResult.
+    // The graph has to outlive the job.
+    std::future<BestEffortResult> submit(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, int priority = 0)
+    {
+        auto job = makeJob(alpha, iterations, tolerance, priority);
+        job->graph = &graph;
+        auto result = job->result.get_future();
+        this->addJob();
+        this->start(job);
+        return result;
+    }
+
+    // The network is prepared once for all jobs running on it at the same
+    // time, by one task starting as many threads as an iteration of the job
+    // gets tasks. It has to outlive the job.
+    std::future<BestEffortResult> submit(Network const& network, double alpha, uint32_t iterations, double tolerance, int priority = 0)
+    {
+        auto job = makeJob(alpha, iterations, tolerance, priority);
+        job->network = &network;
+        auto result = job->result.get_future();
+        this->addJob();
+
+        // Decided under the lock: once waiting, the job is started by the
+        // task preparing the graph and must not be touched here any more.
+        bool prepare = false, ready = false;
+        {
+            std::lock_guard<std::mutex> lock(this->mut);
+            auto& preparation = this->preparations[&network];
+            job->preparation = preparation.lock();
+            if (not job->preparation) {
+                job->preparation = std::make_shared<Preparation>();
+                preparation = job->preparation;
+                prepare = true;
+            }
+            ready = job->preparation->graph != nullptr;
+            if (ready)
+                job->graph = job->preparation->graph.get();
+            else
+                job->preparation->waiting.push_back(job);
+        }
+        if (prepare)
+            this->queue(job, 1);
+        else if (ready)
+            this->start(job);
+        return result;
+    }
+
+    uint32_t getNumThreads() const
+    {
+        return this->numThreads;
+    }
+
+private:
+    struct Job;
+
+    // The graph of a network, shared by the jobs running on it.
+    struct Preparation {
+        std::unique_ptr<PreparedGraph> graph;
+        // Jobs to start once the graph is prepared, guarded by mut.
+        std::vector<std::shared_ptr<Job>> waiting;
+    };
+
+    struct Job {
+        double alpha;
+        uint32_t iterations;
+        double tolerance;
+        int priority;
+
+        Network const* network;
+        // Only for jobs on a network, copied and released under mut.
+        std::shared_ptr<Preparation> preparation;
+        PreparedGraph const* graph;
+
+        // Task i iterates over pages [segments[i], segments[i + 1]).
+        std::vector<PageIndex> segments;
+        std::vector<PageRank> previousPageRanks;
+        std::vector<PageRank> pageRanks;
+        // Alpha times the rank of dangling nodes in previousPageRanks.
+        double dangleSum;
+        uint32_t iteration;
+        // Partial values for each task.
+        std::vector<double> differences;
+        std::vector<double> dangleSums;
+
+        // Tasks of the current iteration not taken yet, guarded by mut.
+        uint32_t numQueued;
+        uint32_t nextTask;
+        // Tasks of the current iteration not finished yet.
+        std::atomic<uint32_t> numUnfinished;
+
+        std::promise<BestEffortResult> result;
+    };
+
+    uint32_t numThreads;
+    std::mutex mut;
+    std::condition_variable cond;
+    bool stopping;
+    uint32_t numActiveJobs;
+    // Jobs with tasks to take, by priority from the highest.
+    std::map<int, std::deque<std::shared_ptr<Job>>, std::greater<int>> queued;
+    // Networks of running jobs.
+    std::map<Network const*, std::weak_ptr<Preparation>> preparations;
+    std::vector<ThreadRAII> threads;
+
+    static std::shared_ptr<Job> makeJob(double alpha, uint32_t iterations, double tolerance, int priority)
+    {
+        ASSERT(iterations > 0, "Invalid iterations=" << iterations);
+        auto job = std::make_shared<Job>();
+        job->alpha = alpha;
+        job->iterations = iterations;
+        job->tolerance = tolerance;
+        job->priority = priority;
+        job->network = nullptr;
+        job->graph = nullptr;
+        job->dangleSum = 0;
+        job->iteration = 0;
+        job->numQueued = 0;
+        job->nextTask = 0;
+        job->numUnfinished = 0;
+        return job;
+    }
+
+    // Sizes the job to its graph and queues its first iteration.
+    void start(std::shared_ptr<Job> const& job)
+    {
+        PreparedGraph const& graph = *job->graph;
+        size_t size = graph.getSize();
+        uint32_t numTasks = this->numTasksFor(size, size + graph.getEdges().getNumEdges());
+
+        for (uint32_t i = 0; i <= numTasks; ++i)
+            job->segments.push_back(graph.getEdges().balancedSegmentBegin(numTasks, i));
+        job->previousPageRanks.assign(size, 1.0 / size);
+        job->pageRanks.assign(size, 0);
+        job->dangleSum = job->alpha * graph.getDanglingNodes().size() / size;
+        job->differences.assign(numTasks, 0);
+        job->dangleSums.assign(numTasks, 0);
+        this->queue(job, numTasks);
+    }
+
+    // Tasks of an iteration over `work` pages and in-links.
+    uint32_t numTasksFor(size_t size, uint64_t work) const
+    {
+        return std::max<uint64_t>(1, std::min<uint64_t>({ (work + minTaskWork - 1) / minTaskWork, this->numThreads, size }));
+    }
+
+    void addJob()
+    {
+        std::lock_guard<std::mutex> lock(this->mut);
+        ++this->numActiveJobs;
+    }
+
+    void queue(std::shared_ptr<Job> const& job, uint32_t numTasks)
+    {
+        job->numUnfinished.store(numTasks, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(this->mut);
+            job->numQueued = numTasks;
+            job->nextTask = 0;
+            this->queued[job->priority].push_back(job);
+        }
+        if (numTasks == 1)
+            this->cond.notify_one();
+        else
+            this->cond.notify_all();
+    }
+
+    void workLoop()
+    {
+        while (true) {
+            std::shared_ptr<Job> job;
+            uint32_t task;
+            {
+                std::unique_lock<std::mutex> lock(this->mut);
+                this->cond.wait(lock, [this] { return not this->queued.empty() || (this->stopping && this->numActiveJobs == 0); });
+                if (this->queued.empty())
+                    return;
+
+                // The job goes to the back of its priority, so jobs of the
+                // same priority take turns.
+                auto& jobs = this->queued.begin()->second;
+                job = jobs.front();
+                jobs.pop_front();
+                task = job->nextTask++;
+                if (job->nextTask < job->numQueued)
+                    jobs.push_back(job);
+                if (jobs.empty())
+                    this->queued.erase(this->queued.begin());
+            }
+
+            if (job->graph == nullptr) {
+                this->prepare(*job);
+            } else {
+                this->iterate(*job, task);
+                // The last task of the iteration sees the results of all of them.
+                if (job->numUnfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    this->finishIteration(job);
+            }
+        }
+    }
+
+    // Prepares the network of the job and starts all jobs waiting for it.
+    void prepare(Job& job)
+    {
+        Network const& network = *job.network;
+        uint64_t work = network.getSize();
+        for (auto const& page : network.getPages())
+            work += page.getLinks().size();
+        std::unique_ptr<PreparedGraph> graph(new PreparedGraph(network, this->numTasksFor(network.getSize(), work)));
+
+        std::vector<std::shared_ptr<Job>> ready;
+        {
+            std::lock_guard<std::mutex> lock(this->mut);
+            job.preparation->graph = std::move(graph);
+            ready.swap(job.preparation->waiting);
+            for (auto const& waiting : ready)
+                waiting->graph = job.preparation->graph.get();
+        }
+        for (auto const& waiting : ready)
+            this->start(waiting);
+    }
+
+    // Pulls the ranks of the pages of `task` from their in-links.
+    static void iterate(Job& job, uint32_t task)
+    {
+        PreparedGraph const& graph = *job.graph;
+        auto const& numLinks = graph.getNumLinks();
+        auto const& edges = graph.getEdges();
+        double baseRank = job.dangleSum / graph.getSize() + (1.0 - job.alpha) / graph.getSize();
+
+        double difference = 0, dangleSum = 0;
+        for (PageIndex v = job.segments[task]; v < job.segments[task + 1]; ++v) {
+            double rank = baseRank;
+            edges.forEachSource(v, [&](PageIndex source) {
+                rank += job.alpha * job.previousPageRanks[source] / numLinks[source];
+            });
+            job.pageRanks[v] = rank;
+            difference += std::abs(job.previousPageRanks[v] - rank);
+            // Dangling nodes are the pages without links.
+            if (numLinks[v] == 0)
+                dangleSum += rank;
+        }
+        job.differences[task] = difference;
+        job.dangleSums[task] = dangleSum;
+    }
+
+    void finishIteration(std::shared_ptr<Job> const& job)
+    {
+        double difference = 0, dangleSum = 0;
+        for (size_t task = 0; task < job->differences.size(); ++task) {
+            difference += job->differences[task];
+            dangleSum += job->dangleSums[task];
+        }
+        ++job->iteration;
+
+        if (difference < job->tolerance || job->iteration == job->iterations) {
+            job->result.set_value({ job->graph->toResult(job->pageRanks), { job->iteration, difference, difference < job->tolerance } });
+            // The last job of a network frees its graph, outside the lock.
+            std::shared_ptr<Preparation> preparation;
+            std::lock_guard<std::mutex> lock(this->mut);
+            preparation.swap(job->preparation);
+            if (preparation && preparation.use_count() == 1)
+                this->preparations.erase(job->network);
+            else
+                preparation.reset();
+            // Threads may be waiting to stop.
+            if (--this->numActiveJobs == 0)
+                this->cond.notify_all();
+            return;
+        }
+
+        std::swap(job->previousPageRanks, job->pageRanks);
+        job->dangleSum = job->alpha * dangleSum;
+        this->queue(job, job->differences.size());
+    }
+};
+
+#endif /* SRC_RANKINGSCHEDULER_HPP_ */
@@ -0,0 +1,67 @@
+#ifndef SRC_RUNBUDGET_HPP_
+#define SRC_RUNBUDGET_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <vector>
+
+#include "immutable/pageIdAndRank.hpp"
+
+// Time limit of a run which can also be cancelled from any thread. Runs only
+// check it between iterations, so they stop at most one iteration late.
+class RunBudget {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Unlimited until cancelled.
+    RunBudget()
+        : deadline(Clock::time_point::max())
+        , cancelled(false)
+    {
+    }
+
+    explicit RunBudget(Clock::duration budget)
+        : deadline(Clock::now() + budget)
+        , cancelled(false)
+    {
+    }
+
+    RunBudget(RunBudget const&) = delete;
+    RunBudget& operator=(RunBudget const&) = delete;
+
+    void cancel()
+    {
+        this->cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    bool isExhausted() const
+    {
+        return this->cancelled.load(std::memory_order_relaxed) || Clock::now() >= this->deadline;
+    }
+
+private:
+    Clock::time_point deadline;
+    std::atomic<bool> cancelled;
+};
+
+// How a run ended. residual is the L1 change of the ranks in the last
+// iteration, infinite when no iteration ran.
+struct RunStatus {
+    uint32_t iterations;
+    double residual;
+    bool converged;
+
+    static RunStatus none()
+    {
+        return { 0, std::numeric_limits<double>::infinity(), false };
+    }
+};
+
+// The ranks a run reached, converged or not.
+struct BestEffortResult {
+    std::vector<PageIdAndRank> ranks;
+    RunStatus status;
+};
+
+#endif /* SRC_RUNBUDGET_HPP_ */
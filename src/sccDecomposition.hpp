@@ -0,0 +1,338 @@
+#ifndef SRC_SCCDECOMPOSITION_HPP_
+#define SRC_SCCDECOMPOSITION_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "immutable/common.hpp"
+#include "csrGraph.hpp"
+#include "pageIndex.hpp"
+#include "parallelUtils.hpp"
+#include "preparedGraph.hpp"
+#include "presolvedGraph.hpp"
+
+// The strongly connected components of a PreparedGraph (maximal sets of pages
+// all reaching each other) in topological order: a component only has
+// in-links from earlier components and from itself. Components come in
+// levels, one level after all the components it has in-links from, so the
+// components of a level do not depend on each other.
+//
+// Found in steps, like the Multistep algorithm of Slota et al.:
+// - the pages PresolvedGraph peels off are components of their own,
+// - the component of a pivot of the remaining core is the pages it reaches
+//   which also reach it, found by two breadth-first searches spread over the
+//   threads,
+// - the other core pages fall into three groups, reaching the pivot, reached
+//   from it or neither, which no component straddles, so every group is run
+//   through Tarjan's algorithm by a thread of its own.
+// Tarjan's algorithm follows in-links, so it gives the components of a group
+// in topological order.
+class SccDecomposition {
+public:
+    // A breadth-first search step over fewer pages is taken by one thread.
+    static constexpr size_t minParallelFrontier = 1 << 12;
+
+    SccDecomposition(PreparedGraph const& graph, uint32_t numThreads)
+        : componentOf(graph.getSize(), 0)
+        , pages()
+        , components(1, 0)
+        , levels(1, 0)
+        , numInnerLinks(graph.getSize(), 0)
+    {
+        size_t size = graph.getSize();
+        auto const& edges = graph.getEdges();
+        PresolvedGraph presolved(graph, numThreads);
+        auto const& corePages = presolved.getCorePages();
+        auto const& coreEdges = presolved.getCoreEdges();
+        size_t numCore = corePages.size();
+        // Out-links among core pages, rows listing the pages linked to.
+        CsrGraph coreLinks = numCore > 0 ? coreEdges.transposed(numThreads) : CsrGraph();
+
+        // Components in topological order, as `pages` and `components` will
+        // be before sorting them by level.
+        std::vector<PageIndex> ordered;
+        std::vector<size_t> bounds(1, 0);
+        ordered.reserve(size);
+        for (auto v : presolved.getUpstream()) {
+            ordered.push_back(v);
+            bounds.push_back(ordered.size());
+        }
+        if (numCore > 0) {
+            std::vector<uint8_t> groups = splitCore(coreEdges, coreLinks, numThreads);
+            std::vector<PageIndex> groupPages[numGroups];
+            std::vector<size_t> groupBounds[numGroups];
+            // Tarjan's numbering of the core pages, shared by the groups.
+            std::vector<uint32_t> order(numCore, 0), low(numCore, 0);
+            runInParallel(numThreads, [&](uint32_t thread) {
+                for (uint32_t group = thread; group < numGroups; group += numThreads) {
+                    groupBounds[group].push_back(0);
+                    if (group == pivotGroup) {
+                        for (PageIndex u = 0; u < numCore; ++u) {
+                            if (groups[u] == pivotGroup)
+                                groupPages[group].push_back(u);
+                        }
+                        groupBounds[group].push_back(groupPages[group].size());
+                    } else {
+                        findComponents(coreEdges, groups, group, order, low, groupPages[group], groupBounds[group]);
+                    }
+                }
+            });
+            for (uint8_t group = 0; group < numGroups; ++group) {
+                for (size_t c = 0; c + 1 < groupBounds[group].size(); ++c) {
+                    for (auto i = groupBounds[group][c]; i < groupBounds[group][c + 1]; ++i)
+                        ordered.push_back(corePages[groupPages[group][i]]);
+                    bounds.push_back(ordered.size());
+                }
+            }
+        }
+        // Deeper downstream layers only link to the layers before them.
+        auto const& downstream = presolved.getDownstream();
+        auto const& downstreamLayers = presolved.getDownstreamLayers();
+        for (size_t k = downstreamLayers.size() - 1; k-- > 0;) {
+            for (auto i = downstreamLayers[k]; i < downstreamLayers[k + 1]; ++i) {
+                ordered.push_back(downstream[i]);
+                bounds.push_back(ordered.size());
+            }
+        }
+        size_t numComponents = bounds.size() - 1;
+
+        // The level of a component is one more than the deepest level it has
+        // in-links from, every component comes after those in `ordered`.
+        for (uint32_t c = 0; c < numComponents; ++c)
+            for (auto i = bounds[c]; i < bounds[c + 1]; ++i)
+                this->componentOf[ordered[i]] = c;
+        std::vector<uint32_t> componentLevels(numComponents, 0);
+        std::vector<size_t> levelSizes(1, 0);
+        for (uint32_t c = 0; c < numComponents; ++c) {
+            uint32_t level = 0;
+            for (auto i = bounds[c]; i < bounds[c + 1]; ++i) {
+                edges.forEachSource(ordered[i], [&](PageIndex source) {
+                    if (this->componentOf[source] != c)
+                        level = std::max(level, componentLevels[this->componentOf[source]] + 1);
+                });
+            }
+            componentLevels[c] = level;
+            if (level + 1 >= levelSizes.size())
+                levelSizes.resize(level + 2, 0);
+            ++levelSizes[level + 1];
+        }
+
+        // Components sorted by level, keeping their order within a level.
+        for (size_t level = 1; level < levelSizes.size(); ++level)
+            levelSizes[level] += levelSizes[level - 1];
+        this->levels = levelSizes;
+        std::vector<uint32_t> numbers(numComponents);
+        for (uint32_t c = 0; c < numComponents; ++c)
+            numbers[c] = levelSizes[componentLevels[c]]++;
+        std::vector<size_t> componentSizes(numComponents + 1, 0);
+        for (uint32_t c = 0; c < numComponents; ++c)
+            componentSizes[numbers[c] + 1] = bounds[c + 1] - bounds[c];
+        for (size_t c = 0; c < numComponents; ++c)
+            componentSizes[c + 1] += componentSizes[c];
+        this->components = componentSizes;
+        this->pages.resize(size);
+        for (uint32_t c = 0; c < numComponents; ++c) {
+            auto position = this->components[numbers[c]];
+            for (auto i = bounds[c]; i < bounds[c + 1]; ++i) {
+                this->pages[position++] = ordered[i];
+                this->componentOf[ordered[i]] = numbers[c];
+            }
+        }
+
+        // Peeled pages are components of their own and never link to
+        // themselves, they would not have been peeled.
+        runInParallel(numThreads, [&](uint32_t thread) {
+            auto end = segmentEnd(numCore, numThreads, thread);
+            for (auto u = segmentBegin(numCore, numThreads, thread); u < end; ++u) {
+                PageIndex v = corePages[u];
+                coreLinks.forEachSource(u, [&](PageIndex target) {
+                    this->numInnerLinks[v] += this->componentOf[corePages[target]] == this->componentOf[v];
+                });
+            }
+        });
+    }
+
+    // Component of every page, a number in [0, getComponents().size() - 1).
+    std::vector<uint32_t> const& getComponentOf() const
+    {
+        return this->componentOf;
+    }
+
+    // Component c is getPages()[getComponents()[c]], ..., getPages()[getComponents()[c + 1] - 1].
+    std::vector<PageIndex> const& getPages() const
+    {
+        return this->pages;
+    }
+
+    std::vector<size_t> const& getComponents() const
+    {
+        return this->components;
+    }
+
+    // Level i is components getLevels()[i], ..., getLevels()[i + 1] - 1.
+    std::vector<size_t> const& getLevels() const
+    {
+        return this->levels;
+    }
+
+    // Links of every page to pages of its own component, links to itself included.
+    std::vector<uint32_t> const& getNumInnerLinks() const
+    {
+        return this->numInnerLinks;
+    }
+
+private:
+    // Groups of core pages relative to the pivot, in topological order.
+    static constexpr uint8_t numGroups = 4;
+    static constexpr uint8_t pivotGroup = 1;
+    // Marks of reached pages, by the search following in-links and out-links.
+    static constexpr uint8_t reachesPivot = 1;
+    static constexpr uint8_t reachedFromPivot = 2;
+
+    std::vector<uint32_t> componentOf;
+    std::vector<PageIndex> pages;
+    std::vector<size_t> components;
+    std::vector<size_t> levels;
+    std::vector<uint32_t> numInnerLinks;
+
+    // Group of every core page: 0 for the pages reaching the pivot only,
+    // pivotGroup for its component, 2 for the pages not related to it and 3
+    // for those reached from it only. Links between groups only go to later
+    // ones. The pivot has the most in- times out-links, likely a page of the
+    // largest component.
+    static std::vector<uint8_t> splitCore(CsrGraph const& inLinks, CsrGraph const& outLinks, uint32_t numThreads)
+    {
+        size_t size = inLinks.getSize();
+        PageIndex pivot = 0;
+        uint64_t pivotDegrees = 0;
+        for (PageIndex u = 0; u < size; ++u) {
+            uint64_t degrees = (inLinks.getOffsets()[u + 1] - inLinks.getOffsets()[u]) * (outLinks.getOffsets()[u + 1] - outLinks.getOffsets()[u]);
+            if (degrees > pivotDegrees) {
+                pivot = u;
+                pivotDegrees = degrees;
+            }
+        }
+
+        std::vector<std::atomic<uint8_t>> reached(size);
+        reach(inLinks, pivot, reachesPivot, reached, numThreads);
+        reach(outLinks, pivot, reachedFromPivot, reached, numThreads);
+
+        // By the marks of a page.
+        static constexpr uint8_t groupOfMarks[4] = { 2, 0, 3, pivotGroup };
+        std::vector<uint8_t> groups(size);
+        for (PageIndex u = 0; u < size; ++u)
+            groups[u] = groupOfMarks[reached[u].load(std::memory_order_relaxed)];
+        return groups;
+    }
+
+    // Adds `mark` to every page reachable from `start` along the rows of
+    // `links`, `start` included. Steps run in parallel, a part of the
+    // frontier per thread.
+    static void reach(CsrGraph const& links, PageIndex start, uint8_t mark, std::vector<std::atomic<uint8_t>>& reached, uint32_t numThreads)
+    {
+        auto visit = [&](PageIndex v, std::vector<PageIndex>& next) {
+            if ((reached[v].load(std::memory_order_relaxed) & mark) == 0 && (reached[v].fetch_or(mark, std::memory_order_relaxed) & mark) == 0)
+                next.push_back(v);
+        };
+        // Frontiers of every other step, a part per thread.
+        std::vector<std::vector<PageIndex>> frontiers[2] = { std::vector<std::vector<PageIndex>>(numThreads), std::vector<std::vector<PageIndex>>(numThreads) };
+        visit(start, frontiers[0][0]);
+        Barrier barrier { numThreads };
+
+        runInParallel(numThreads, [&](uint32_t thread) {
+            for (uint32_t step = 0;; ++step) {
+                auto const& current = frontiers[step % 2];
+                auto& next = frontiers[(step + 1) % 2][thread];
+                next.clear();
+                size_t total = 0;
+                for (auto const& part : current)
+                    total += part.size();
+                if (total == 0)
+                    return;
+
+                if (total < minParallelFrontier) {
+                    // The first thread goes on alone until the frontier grows.
+                    if (thread == 0) {
+                        std::vector<PageIndex> frontier, following;
+                        for (auto const& part : current)
+                            frontier.insert(frontier.end(), part.begin(), part.end());
+                        while (not frontier.empty() && frontier.size() < minParallelFrontier) {
+                            following.clear();
+                            for (auto v : frontier)
+                                links.forEachSource(v, [&](PageIndex w) { visit(w, following); });
+                            frontier.swap(following);
+                        }
+                        next.swap(frontier);
+                    }
+                } else {
+                    size_t begin = segmentBegin(total, numThreads, thread);
+                    size_t end = segmentEnd(total, numThreads, thread);
+                    size_t offset = 0;
+                    for (auto const& part : current) {
+                        for (size_t i = std::max(begin, offset); i < std::min(end, offset + part.size()); ++i)
+                            links.forEachSource(part[i - offset], [&](PageIndex w) { visit(w, next); });
+                        offset += part.size();
+                    }
+                }
+                barrier.await();
+            }
+        });
+    }
+
+    // Iterative Tarjan's algorithm over the in-links of the pages of `group`
+    // only, appending its components to `groupPages` and their ends to
+    // `groupBounds` in topological order. order and low start at 0 for the
+    // pages of the group.
+    static void findComponents(CsrGraph const& inLinks, std::vector<uint8_t> const& groups, uint8_t group, std::vector<uint32_t>& order,
+        std::vector<uint32_t>& low, std::vector<PageIndex>& groupPages, std::vector<size_t>& groupBounds)
+    {
+        // Order of the pages whose component is found already.
+        static constexpr uint32_t assigned = UINT32_MAX;
+        uint32_t numVisited = 0;
+        std::vector<PageIndex> stack;
+        // Pages being visited, with the next of their in-links to follow.
+        std::vector<std::pair<PageIndex, uint64_t>> path;
+        auto visit = [&](PageIndex v) {
+            order[v] = low[v] = ++numVisited;
+            stack.push_back(v);
+            path.push_back({ v, inLinks.getOffsets()[v] });
+        };
+
+        for (PageIndex root = 0; root < inLinks.getSize(); ++root) {
+            if (groups[root] != group || order[root] != 0)
+                continue;
+            visit(root);
+            while (not path.empty()) {
+                PageIndex v = path.back().first;
+                if (path.back().second < inLinks.getOffsets()[v + 1]) {
+                    PageIndex source = inLinks.getSources()[path.back().second++];
+                    // Links from other groups come from earlier ones.
+                    if (groups[source] != group)
+                        continue;
+                    if (order[source] == 0)
+                        visit(source);
+                    else if (order[source] != assigned)
+                        low[v] = std::min(low[v], order[source]);
+                    continue;
+                }
+
+                path.pop_back();
+                if (not path.empty())
+                    low[path.back().first] = std::min(low[path.back().first], low[v]);
+                if (low[v] == order[v]) {
+                    PageIndex w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        order[w] = assigned;
+                        groupPages.push_back(w);
+                    } while (w != v);
+                    groupBounds.push_back(groupPages.size());
+                }
+            }
+        }
+    }
+};
+
+#endif /* SRC_SCCDECOMPOSITION_HPP_ */
@@ -0,0 +1,284 @@
+#ifndef SRC_SCCPAGERANKCOMPUTER_HPP_
+#define SRC_SCCPAGERANKCOMPUTER_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+#include "immutable/pageRankComputer.hpp"
+#include "parallelUtils.hpp"
+#include "preparedGraph.hpp"
+#include "sccDecomposition.hpp"
+
+// Solves the strongly connected components of the graph one after another in
+// topological order, every one to convergence on its own, instead of
+// iterating all pages together.
+//
+// As explained for LumpedPageRankComputer the ranks are r = base * y with
+//   y = 1 + alpha * A * y
+// and base = (1 - alpha) / (n - alpha * (y of dangling pages)). The y of a
+// component only depends on the y of the components linking to it, which
+// are solved by then: a page on its own is solved directly, others by Jacobi
+// iterations over the component, every one scaled to balance the component
+// like LumpedPageRankComputer balances the whole graph:
+//   (sum of y) - alpha * (y passed on within the component) = (sum of the y of the pages without links within the component)
+// Unscaled, iterations only slowly get rid of the y circling within the
+// component (about 90 iterations on rmat/1M and erdosRenyi/1M), scaled ones
+// take 12 to 15.
+//
+// The components of a level are solved in parallel, those of at least
+// minParallelPages pages by all threads together, and runs of small levels by
+// one thread. On graphs of many components chained one after another the
+// power iteration takes as many iterations as rank takes to flow down the
+// chain, whereas every component here converges after a few. Graphs of a
+// single big component only pay for the decomposition.
+//
+// Convergence is checked per component, on its share of `tolerance`.
+class SccPageRankComputer : public PageRankComputer {
+public:
+    // Components and levels with fewer pages are solved by one thread.
+    static constexpr size_t minParallelPages = 1 << 12;
+
+    SccPageRankComputer(uint32_t numThreadsArg)
+        : numThreads(numThreadsArg) {};
+
+    std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha, uint32_t iterations, double tolerance) const
+    {
+        PreparedGraph graph(network, numThreads);
+        return computeForGraph(graph, alpha, iterations, tolerance);
+    }
+
+    std::vector<PageIdAndRank> computeTopK(Network const& network, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        PreparedGraph graph(network, numThreads);
+        return computeTopKForGraph(graph, alpha, iterations, tolerance, k);
+    }
+
+    std::vector<PageIdAndRank> computeForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance) const
+    {
+        return graph.toResult(computeRanks(graph, alpha, iterations, tolerance));
+    }
+
+    std::vector<PageIdAndRank> computeTopKForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        return graph.toTopKResult(computeRanks(graph, alpha, iterations, tolerance), k, numThreads);
+    }
+
+    std::string getName() const
+    {
+        return "SccPageRankComputer[" + std::to_string(this->numThreads) + "]";
+    }
+
+private:
+    uint32_t numThreads;
+
+    // Sums of the threads solving a component together, one each.
+    struct PartialSums {
+        PartialSums(uint32_t numParts)
+            : inflows(numParts)
+            , masses(numParts)
+            , differences(numParts)
+        {
+        }
+
+        std::vector<double> inflows;
+        std::vector<double> masses;
+        std::vector<double> differences;
+    };
+
+    // Ranks indexed by the page indices of `graph`.
+    std::vector<PageRank> computeRanks(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance) const
+    {
+        size_t networkSize = graph.getSize();
+        auto const& danglingNodes = graph.getDanglingNodes();
+        SccDecomposition scc(graph, numThreads);
+        auto const& components = scc.getComponents();
+        auto const& levels = scc.getLevels();
+        auto componentSize = [&](size_t c) { return components[c + 1] - components[c]; };
+        auto levelSize = [&](size_t l) { return components[levels[l + 1]] - components[levels[l]]; };
+
+        // y of every page, later its rank, and twice what it passes on per
+        // link, iterations of a component reading one and writing the other.
+        // Solved pages have the same in both.
+        std::vector<PageRank> pageRanks(networkSize);
+        std::vector<double> passed[2] = { std::vector<double>(networkSize), std::vector<double>(networkSize) };
+        PartialSums shared(numThreads);
+        std::vector<uint32_t> failures(numThreads, 0);
+        std::vector<double> danglingSums(numThreads);
+        Barrier barrier { numThreads };
+
+        runInParallel(numThreads, [&](uint32_t thread) {
+            PartialSums own(1);
+            auto solveAlone = [&](size_t c) {
+                if (not solveComponent(graph, scc, c, pageRanks, passed, alpha, iterations, tolerance, 1, 0, own, [] {}))
+                    ++failures[thread];
+            };
+
+            size_t numLevels = levels.size() - 1;
+            size_t l = 0;
+            while (l < numLevels) {
+                if (levelSize(l) >= minParallelPages) {
+                    // Small components by the thread their first page falls
+                    // to, then the big ones together.
+                    size_t levelBegin = components[levels[l]];
+                    auto first = std::lower_bound(components.begin() + levels[l], components.begin() + levels[l + 1],
+                        levelBegin + segmentBegin(levelSize(l), numThreads, thread));
+                    auto last = std::lower_bound(first, components.begin() + levels[l + 1], levelBegin + segmentEnd(levelSize(l), numThreads, thread));
+                    for (size_t c = first - components.begin(); c < size_t(last - components.begin()); ++c) {
+                        if (componentSize(c) < minParallelPages)
+                            solveAlone(c);
+                    }
+                    barrier.await();
+                    for (size_t c = levels[l]; c < levels[l + 1]; ++c) {
+                        if (componentSize(c) < minParallelPages)
+                            continue;
+                        bool solved = solveComponent(graph, scc, c, pageRanks, passed, alpha, iterations, tolerance, numThreads, thread, shared,
+                            [&] { barrier.await(); });
+                        if (not solved && thread == 0)
+                            ++failures[thread];
+                        barrier.await();
+                    }
+                    ++l;
+                } else {
+                    size_t first = l;
+                    while (l < numLevels && levelSize(l) < minParallelPages)
+                        ++l;
+                    if (thread == 0) {
+                        for (size_t c = levels[first]; c < levels[l]; ++c)
+                            solveAlone(c);
+                    }
+                    barrier.await();
+                }
+            }
+
+            double danglingSum = 0;
+            auto danglingEnd = segmentEnd(danglingNodes.size(), numThreads, thread);
+            for (auto i = segmentBegin(danglingNodes.size(), numThreads, thread); i < danglingEnd; ++i)
+                danglingSum += pageRanks[danglingNodes[i]];
+            danglingSums[thread] = danglingSum;
+
+            barrier.await();
+
+            danglingSum = 0;
+            for (uint32_t t = 0; t < numThreads; ++t)
+                danglingSum += danglingSums[t];
+            double base = (1.0 - alpha) / (networkSize - alpha * danglingSum);
+            auto end = segmentEnd(networkSize, numThreads, thread);
+            for (auto v = segmentBegin(networkSize, numThreads, thread); v < end; ++v)
+                pageRanks[v] *= base;
+        });
+
+        uint32_t numFailures = 0;
+        for (auto count : failures)
+            numFailures += count;
+        ASSERT(numFailures == 0, "Not able to find result in iterations=" << iterations);
+        return pageRanks;
+    }
+
+    // Finds the y of the pages of component c, its pages split over numParts
+    // threads of which this is `part`, sums adding up in `sums` and sync()
+    // waiting for all of them. False when it does not converge in time.
+    template <typename Sync>
+    static bool solveComponent(PreparedGraph const& graph, SccDecomposition const& scc, size_t c, std::vector<PageRank>& pageRanks,
+        std::vector<double> (&passed)[2], double alpha, uint32_t iterations, double tolerance, uint32_t numParts, uint32_t part, PartialSums& sums,
+        Sync const& sync)
+    {
+        auto const& numLinks = graph.getNumLinks();
+        auto const& edges = graph.getEdges();
+        auto const& componentOf = scc.getComponentOf();
+        auto const& pages = scc.getPages();
+        auto const& numInnerLinks = scc.getNumInnerLinks();
+        size_t begin = scc.getComponents()[c];
+        size_t size = scc.getComponents()[c + 1] - begin;
+
+        if (size == 1) {
+            // Only links to itself come from within the component.
+            PageIndex v = pages[begin];
+            double y = 1.0;
+            edges.forEachSource(v, [&](PageIndex source) {
+                if (source != v)
+                    y += passed[0][source];
+            });
+            if (numInnerLinks[v] > 0)
+                y /= 1.0 - alpha * numInnerLinks[v] / numLinks[v];
+            pageRanks[v] = y;
+            passed[0][v] = passed[1][v] = numLinks[v] > 0 ? alpha / numLinks[v] * y : 0;
+            return true;
+        }
+
+        // Pages of a component of several pages all have links, starting
+        // from the y passed on from other components.
+        size_t partBegin = begin + segmentBegin(size, numParts, part);
+        size_t partEnd = begin + segmentEnd(size, numParts, part);
+        double inflow = 0;
+        for (auto i = partBegin; i < partEnd; ++i) {
+            PageIndex v = pages[i];
+            double y = 1.0;
+            edges.forEachSource(v, [&](PageIndex source) {
+                if (componentOf[source] != c)
+                    y += passed[0][source];
+            });
+            inflow += y;
+            passed[0][v] = alpha / numLinks[v] * y;
+        }
+        sums.inflows[part] = inflow;
+        sync();
+        inflow = 0;
+        for (uint32_t t = 0; t < numParts; ++t)
+            inflow += sums.inflows[t];
+
+        uint32_t i = 0;
+        for (; i < iterations; ++i) {
+            auto const& previous = passed[i % 2];
+            auto& current = passed[(i + 1) % 2];
+
+            // Weighted by what of their y the pages keep within the component.
+            double mass = 0;
+            for (auto k = partBegin; k < partEnd; ++k) {
+                PageIndex v = pages[k];
+                double y = 1.0;
+                edges.forEachSource(v, [&](PageIndex source) { y += previous[source]; });
+                current[v] = y;
+                mass += y * (1.0 - alpha * numInnerLinks[v] / numLinks[v]);
+            }
+            sums.masses[part] = mass;
+            sync();
+
+            mass = 0;
+            for (uint32_t t = 0; t < numParts; ++t)
+                mass += sums.masses[t];
+            double scale = inflow / mass;
+            double difference = 0;
+            for (auto k = partBegin; k < partEnd; ++k) {
+                PageIndex v = pages[k];
+                double weight = alpha / numLinks[v];
+                double y = current[v] * scale;
+                difference += std::abs(y - previous[v] / weight);
+                current[v] = y * weight;
+            }
+            sums.differences[part] = difference;
+            sync();
+
+            difference = 0;
+            for (uint32_t t = 0; t < numParts; ++t)
+                difference += sums.differences[t];
+            // The rank of a page is at most its y / n.
+            if (difference < tolerance * size)
+                break;
+        }
+        if (i == iterations)
+            return false;
+
+        auto const& solved = passed[(i + 1) % 2];
+        for (auto k = partBegin; k < partEnd; ++k) {
+            PageIndex v = pages[k];
+            passed[i % 2][v] = solved[v];
+            pageRanks[v] = solved[v] / (alpha / numLinks[v]);
+        }
+        return true;
+    }
+};
+
+#endif /* SRC_SCCPAGERANKCOMPUTER_HPP_ */
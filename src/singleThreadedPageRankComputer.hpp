@@ -1,13 +1,14 @@
 #ifndef SRC_SINGLETHREADEDPAGERANKCOMPUTER_HPP_
 #define SRC_SINGLETHREADEDPAGERANKCOMPUTER_HPP_
 
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "immutable/network.hpp"
 #include "immutable/pageIdAndRank.hpp"
 #include "immutable/pageRankComputer.hpp"
+#include "instrumentation.hpp"
+#include "preparedGraph.hpp"
+#include "runBudget.hpp"
 
 class SingleThreadedPageRankComputer : public PageRankComputer {
 public:
@@ -15,73 +16,109 @@ public:
 
     std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha, uint32_t iterations, double tolerance) const
     {
-        std::unordered_map<PageId, PageRank, PageIdHash> pageHashMap;
-        for (auto const& page : network.getPages()) {
-            page.generateId(network.getGenerator());
-            pageHashMap[page.getId()] = 1.0 / network.getSize();
-        }
+        PreparedGraph graph(network, 1);
+        return computeForGraph(graph, alpha, iterations, tolerance);
+    }
 
-        std::unordered_map<PageId, uint32_t, PageIdHash> numLinks;
-        for (auto page : network.getPages()) {
-            numLinks[page.getId()] = page.getLinks().size();
-        }
+    std::vector<PageIdAndRank> computeTopK(Network const& network, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        PreparedGraph graph(network, 1);
+        return computeTopKForGraph(graph, alpha, iterations, tolerance, k);
+    }
 
-        std::unordered_set<PageId, PageIdHash> danglingNodes;
-        for (auto page : network.getPages()) {
-            if (page.getLinks().size() == 0) {
-                danglingNodes.insert(page.getId());
-            }
-        }
+    std::vector<PageIdAndRank> computeForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance) const
+    {
+        return graph.toResult(computeRanks(graph, alpha, iterations, tolerance));
+    }
 
-        std::unordered_map<PageId, std::vector<PageId>, PageIdHash> edges;
-        for (auto page : network.getPages()) {
-            for (auto link : page.getLinks()) {
-                edges[link].push_back(page.getId());
-            }
-        }
+    std::vector<PageIdAndRank> computeTopKForGraph(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, uint32_t k) const
+    {
+        return graph.toTopKResult(computeRanks(graph, alpha, iterations, tolerance), k, 1);
+    }
+
+    // Best effort: stops once converged, after `iterations` or at the first
+    // iteration boundary after the budget is exhausted, and returns the ranks
+    // reached. Setting up the graph is not interrupted.
+    BestEffortResult computeWithBudget(Network const& network, double alpha, uint32_t iterations, double tolerance, RunBudget const& budget) const
+    {
+        PreparedGraph graph(network, 1);
+        return computeWithBudget(graph, alpha, iterations, tolerance, budget);
+    }
+
+    BestEffortResult computeWithBudget(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, RunBudget const& budget) const
+    {
+        RunStatus status = RunStatus::none();
+        auto pageRanks = computeRanks(graph, alpha, iterations, tolerance, &budget, status);
+        return { graph.toResult(pageRanks), status };
+    }
+
+    std::string getName() const
+    {
+        return "SingleThreadedPageRankComputer";
+    }
+
+private:
+    // Converged ranks indexed by the page indices of `graph`.
+    std::vector<PageRank> computeRanks(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance) const
+    {
+        RunStatus status = RunStatus::none();
+        auto pageRanks = computeRanks(graph, alpha, iterations, tolerance, nullptr, status);
+        ASSERT(status.converged, "Not able to find result in iterations=" << iterations);
+        return pageRanks;
+    }
+
+    // Ranks when the run stopped, also early once `budget` (if any) is exhausted.
+    std::vector<PageRank> computeRanks(PreparedGraph const& graph, double alpha, uint32_t iterations, double tolerance, RunBudget const* budget, RunStatus& status) const
+    {
+        std::vector<PageRank> pageRanks(graph.getSize(), 1.0 / graph.getSize());
+
+        auto const& numLinks = graph.getNumLinks();
+        auto const& danglingNodes = graph.getDanglingNodes();
+
+        // Pages linking to page v are sources[offsets[v]], ..., sources[offsets[v + 1] - 1].
+        auto const& offsets = graph.getEdges().getOffsets();
+        auto const& sources = graph.getEdges().getSources();
+
+        INSTRUMENT(RunReport report(getName(), 1, graph.getSize(), graph.getEdges().getNumEdges());)
+        INSTRUMENT(report.setSetup(graph.getIdGenerationSeconds(), graph.getSetupSeconds());)
+        INSTRUMENT(PhaseTimer runTimer, timer;)
 
         for (uint32_t i = 0; i < iterations; ++i) {
-            std::unordered_map<PageId, PageRank, PageIdHash> previousPageHashMap = pageHashMap;
+            INSTRUMENT(timer.lap();)
+            std::vector<PageRank> previousPageRanks = pageRanks;
+            INSTRUMENT(report.addPhase(0, RunReport::copy, timer.lap());)
 
             double dangleSum = 0;
             for (auto danglingNode : danglingNodes) {
-                dangleSum += previousPageHashMap[danglingNode];
+                dangleSum += previousPageRanks[danglingNode];
             }
             dangleSum = dangleSum * alpha;
+            INSTRUMENT(report.addPhase(0, RunReport::dangleSum, timer.lap());)
 
             double difference = 0;
-            for (auto& pageMapElem : pageHashMap) {
-                PageId pageId = pageMapElem.first;
+            for (PageIndex pageIndex = 0; pageIndex < pageRanks.size(); ++pageIndex) {
+                double danglingWeight = 1.0 / graph.getSize();
+                pageRanks[pageIndex] = dangleSum * danglingWeight + (1.0 - alpha) / graph.getSize();
 
-                double danglingWeight = 1.0 / network.getSize();
-                pageMapElem.second = dangleSum * danglingWeight + (1.0 - alpha) / network.getSize();
-
-                if (edges.count(pageId) > 0) {
-                    for (auto link : edges[pageId]) {
-                        pageMapElem.second += alpha * previousPageHashMap[link] / numLinks[link];
-                    }
+                for (uint64_t e = offsets[pageIndex]; e < offsets[pageIndex + 1]; ++e) {
+                    PageIndex link = sources[e];
+                    pageRanks[pageIndex] += alpha * previousPageRanks[link] / numLinks[link];
                 }
-                difference += std::abs(previousPageHashMap[pageId] - pageHashMap[pageId]);
-            }
-
-            std::vector<PageIdAndRank> result;
-            for (auto iter : pageHashMap) {
-                result.push_back(PageIdAndRank(iter.first, iter.second));
+                difference += std::abs(previousPageRanks[pageIndex] - pageRanks[pageIndex]);
             }
-
-            ASSERT(result.size() == network.getSize(), "Invalid result size=" << result.size() << ", for network" << network);
-
-            if (difference < tolerance) {
-                return result;
+            INSTRUMENT(report.addPhase(0, RunReport::edges, timer.lap());)
+            INSTRUMENT(report.addIteration(difference);)
+
+            if (difference < tolerance || i + 1 == iterations || (budget != nullptr && budget->isExhausted())) {
+                INSTRUMENT(report.setTotal(runTimer.lap());)
+                INSTRUMENT(Instrumentation::report(report);)
+                status = { i + 1, difference, difference < tolerance };
+                return pageRanks;
             }
         }
 
-        ASSERT(false, "Not able to find result in iterations=" << iterations);
-    }
-
-    std::string getName() const
-    {
-        return "SingleThreadedPageRankComputer";
+        // No iterations at all.
+        return pageRanks;
     }
 };
 
@@ -0,0 +1,75 @@
+#ifndef SRC_TOPKSELECTOR_HPP_
+#define SRC_TOPKSELECTOR_HPP_
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include "immutable/pageIdAndRank.hpp"
+#include "pageIndex.hpp"
+#include "parallelUtils.hpp"
+
+// Picks indices of the k highest ranks without sorting all of them. Every
+// thread keeps a min-heap of the k best pages of its segment, the heaps are
+// merged at the end. Ties go to the smaller index, so the result is
+// deterministic. Indices come out ordered from the highest rank.
+class TopKSelector {
+public:
+    static std::vector<PageIndex> select(std::vector<PageRank> const& ranks, uint32_t k, uint32_t numThreads)
+    {
+        Better better { ranks };
+        std::vector<std::vector<PageIndex>> partial(numThreads);
+        runInParallel(numThreads, [&](uint32_t thread) {
+            Heap heap { better };
+            auto end = segmentEnd(ranks.size(), numThreads, thread);
+            for (auto i = segmentBegin(ranks.size(), numThreads, thread); i < end; ++i)
+                push(heap, better, k, i);
+            partial[thread] = drain(heap);
+        });
+
+        Heap heap { better };
+        for (auto const& indices : partial)
+            for (auto i : indices)
+                push(heap, better, k, i);
+
+        auto result = drain(heap);
+        std::reverse(result.begin(), result.end());
+        return result;
+    }
+
+private:
+    // True when page a ranks above page b. With it the heap keeps the worst
+    // of the selected pages on top.
+    struct Better {
+        std::vector<PageRank> const& ranks;
+
+        bool operator()(PageIndex a, PageIndex b) const
+        {
+            return ranks[a] > ranks[b] || (ranks[a] == ranks[b] && a < b);
+        }
+    };
+
+    typedef std::priority_queue<PageIndex, std::vector<PageIndex>, Better> Heap;
+
+    static void push(Heap& heap, Better const& better, uint32_t k, PageIndex index)
+    {
+        if (heap.size() < k) {
+            heap.push(index);
+        } else if (k > 0 && better(index, heap.top())) {
+            heap.pop();
+            heap.push(index);
+        }
+    }
+
+    // Empties the heap, from the lowest rank.
+    static std::vector<PageIndex> drain(Heap& heap)
+    {
+        std::vector<PageIndex> indices;
+        indices.reserve(heap.size());
+        for (; not heap.empty(); heap.pop())
+            indices.push_back(heap.top());
+        return indices;
+    }
+};
+
+#endif /* SRC_TOPKSELECTOR_HPP_ */
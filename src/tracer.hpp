@@ -0,0 +1,193 @@
+#ifndef SRC_TRACER_HPP_
+#define SRC_TRACER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "immutable/common.hpp"
+
+// Timeline of the phases and barrier waits of every thread, built with
+// -DPAGERANK_TRACING (cmake -DPAGERANK_TRACING=ON). Without it TRACE(...)
+// drops its arguments and nothing is recorded.
+#ifdef PAGERANK_TRACING
+#define TRACE(...) __VA_ARGS__
+#else
+#define TRACE(...)
+#endif
+
+// Spans go to a ring buffer of the recording thread, so recording takes no
+// lock and only the last spanCapacity spans of a thread are kept. Buffers
+// outlive their threads and are handed to the next new thread, which
+// continues their track under its own name. writeChromeTrace() dumps all
+// buffers as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev), and
+// when the PAGERANK_TRACE environment variable names a file the trace is
+// written there at exit. Dumping is meant for when no thread is recording.
+class Tracer {
+public:
+    static constexpr size_t spanCapacity = 1 << 16;
+
+    static uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Records `name` (a string literal) from beginNs until now and returns
+    // now, the begin of the next span. arg is shown when not negative.
+    static uint64_t lap(char const* name, uint64_t beginNs, int64_t arg = -1)
+    {
+        uint64_t endNs = now();
+        record(name, beginNs, endNs, arg);
+        return endNs;
+    }
+
+    static void record(char const* name, uint64_t beginNs, uint64_t endNs, int64_t arg = -1)
+    {
+        Buffer& buffer = threadBuffer();
+        uint64_t position = buffer.written.load(std::memory_order_relaxed);
+        buffer.spans[position % spanCapacity] = { name, beginNs, endNs, arg };
+        buffer.written.store(position + 1, std::memory_order_release);
+    }
+
+    // Names the track of the calling thread.
+    static void setThreadName(std::string const& name)
+    {
+        Buffer& buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(state().mut);
+        buffer.name = name;
+    }
+
+    static void writeChromeTrace(std::ostream& out)
+    {
+        std::lock_guard<std::mutex> lock(state().mut);
+        uint64_t epoch = UINT64_MAX;
+        for (auto const& buffer : state().buffers)
+            for (uint64_t i = firstKept(*buffer); i < buffer->written.load(std::memory_order_acquire); ++i)
+                epoch = std::min(epoch, buffer->spans[i % spanCapacity].beginNs);
+
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (uint32_t tid = 0; tid < state().buffers.size(); ++tid) {
+            Buffer const& buffer = *state().buffers[tid];
+            out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                << ",\"args\":{\"name\":\"" << (buffer.name.empty() ? "thread " + std::to_string(tid) : buffer.name) << "\"}}";
+            first = false;
+            for (uint64_t i = firstKept(buffer); i < buffer.written.load(std::memory_order_acquire); ++i) {
+                Span const& span = buffer.spans[i % spanCapacity];
+                // Microseconds, with the nanoseconds as decimals.
+                out << ",\n{\"name\":\"" << span.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                    << ",\"ts\":" << (span.beginNs - epoch) / 1000 << "." << digits3((span.beginNs - epoch) % 1000)
+                    << ",\"dur\":" << (span.endNs - span.beginNs) / 1000 << "." << digits3((span.endNs - span.beginNs) % 1000);
+                if (span.arg >= 0)
+                    out << ",\"args\":{\"iteration\":" << span.arg << "}";
+                out << "}";
+            }
+        }
+        out << "\n]}" << std::endl;
+    }
+
+    // Forgets all recorded spans, for when no thread is recording.
+    static void clear()
+    {
+        std::lock_guard<std::mutex> lock(state().mut);
+        for (auto const& buffer : state().buffers)
+            buffer->written.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    struct Span {
+        char const* name;
+        uint64_t beginNs;
+        uint64_t endNs;
+        int64_t arg;
+    };
+
+    struct Buffer {
+        std::vector<Span> spans;
+        std::atomic<uint64_t> written;
+        std::string name;
+
+        Buffer()
+            : spans(spanCapacity)
+            , written(0)
+            , name()
+        {
+        }
+    };
+
+    struct State {
+        std::mutex mut;
+        std::vector<std::unique_ptr<Buffer>> buffers;
+        // Buffers of finished threads.
+        std::vector<Buffer*> free;
+
+        ~State()
+        {
+            char const* path = std::getenv("PAGERANK_TRACE");
+            if (path == nullptr)
+                return;
+            std::ofstream file(path);
+            ASSERT(file.good(), "Cannot write PAGERANK_TRACE=" << path);
+            writeChromeTrace(file);
+        }
+    };
+
+    // Owned by its thread, returns the buffer when the thread ends.
+    struct ThreadSlot {
+        Buffer* buffer;
+
+        ThreadSlot()
+            : buffer(nullptr)
+        {
+            std::lock_guard<std::mutex> lock(state().mut);
+            if (state().free.empty()) {
+                state().buffers.emplace_back(new Buffer());
+                buffer = state().buffers.back().get();
+            } else {
+                buffer = state().free.back();
+                buffer->name.clear();
+                state().free.pop_back();
+            }
+        }
+
+        ~ThreadSlot()
+        {
+            std::lock_guard<std::mutex> lock(state().mut);
+            state().free.push_back(buffer);
+        }
+    };
+
+    static State& state()
+    {
+        static State instance;
+        return instance;
+    }
+
+    static Buffer& threadBuffer()
+    {
+        thread_local ThreadSlot slot;
+        return *slot.buffer;
+    }
+
+    static uint64_t firstKept(Buffer const& buffer)
+    {
+        uint64_t written = buffer.written.load(std::memory_order_acquire);
+        return written > spanCapacity ? written - spanCapacity : 0;
+    }
+
+    static std::string digits3(uint64_t value)
+    {
+        std::string digits = std::to_string(value);
+        return std::string(3 - digits.size(), '0') + digits;
+    }
+};
+
+#endif /* SRC_TRACER_HPP_ */
@@ -0,0 +1,79 @@
+#include <mutex>
+#include <unordered_map>
+
+#include "../src/immutable/common.hpp"
+#include "../src/immutable/pageId.hpp"
+
+#include "../src/concurrentPageIdMap.hpp"
+#include "../src/parallelUtils.hpp"
+
+#include "./lib/performanceTimer.hpp"
+#include "./lib/samplingProfiler.hpp"
+#include "./lib/simpleIdGenerator.hpp"
+
+// The same fill-then-resolve workload as the setup of MultiThreadedPageRankComputer:
+// every thread registers its segment of ids, then looks up `lookupsPerKey` ids per key.
+uint32_t const lookupsPerKey = 4;
+
+void concurrentMapWithNumThreads(std::vector<PageId> const& ids, uint32_t numThreads)
+{
+    PerformanceTimer timer;
+    ConcurrentPageIdMap map(ids.size());
+    runInParallel(numThreads, [&](uint32_t thread) {
+        auto end = segmentEnd(ids.size(), numThreads, thread);
+        for (auto i = segmentBegin(ids.size(), numThreads, thread); i < end; ++i)
+            map.insert(i, ids[i]);
+    });
+    runInParallel(numThreads, [&](uint32_t thread) {
+        auto end = segmentEnd(ids.size(), numThreads, thread);
+        for (auto i = segmentBegin(ids.size(), numThreads, thread); i < end; ++i) {
+            for (uint32_t j = 0; j < lookupsPerKey; ++j) {
+                PageIndex index;
+                auto key = (i * 7919 + j * 104729) % ids.size();
+                ASSERT(map.find(ids[key], index) && index == key, "Lookup failed for " << ids[key]);
+            }
+        }
+    });
+    timer.printTimeDifference("ConcurrentPageIdMap Performance Test [" + std::to_string(ids.size()) + " ids, " + std::to_string(numThreads) + " threads]");
+}
+
+void mutexMapWithNumThreads(std::vector<PageId> const& ids, uint32_t numThreads)
+{
+    PerformanceTimer timer;
+    std::unordered_map<PageId, PageIndex, PageIdHash> map;
+    std::mutex mut;
+    map.reserve(ids.size());
+    runInParallel(numThreads, [&](uint32_t thread) {
+        auto end = segmentEnd(ids.size(), numThreads, thread);
+        for (auto i = segmentBegin(ids.size(), numThreads, thread); i < end; ++i) {
+            std::lock_guard<std::mutex> lock(mut);
+            map.emplace(ids[i], i);
+        }
+    });
+    runInParallel(numThreads, [&](uint32_t thread) {
+        auto end = segmentEnd(ids.size(), numThreads, thread);
+        for (auto i = segmentBegin(ids.size(), numThreads, thread); i < end; ++i) {
+            for (uint32_t j = 0; j < lookupsPerKey; ++j) {
+                auto key = (i * 7919 + j * 104729) % ids.size();
+                std::lock_guard<std::mutex> lock(mut);
+                ASSERT(map.at(ids[key]) == key, "Lookup failed for " << ids[key]);
+            }
+        }
+    });
+    timer.printTimeDifference("Mutex std::unordered_map Performance Test [" + std::to_string(ids.size()) + " ids, " + std::to_string(numThreads) + " threads]");
+}
+
+int main()
+{
+    SimpleIdGenerator idGenerator("2000f1ffa5ce95d0f1e1893598e6aeeb2c214c85a88e3569d62c2dccd06a8725");
+    std::vector<PageId> ids;
+    for (uint32_t i = 0; i < 500000; ++i)
+        ids.push_back(idGenerator.generateId(std::to_string(i)));
+
+    for (uint32_t numThreads : { 1, 2, 4, 8 }) {
+        concurrentMapWithNumThreads(ids, numThreads);
+        mutexMapWithNumThreads(ids, numThreads);
+    }
+
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include "lib/networkGenerator.hpp"
 #include "lib/performanceTimer.hpp"
 #include "lib/resultVerificator.hpp"
+#include "lib/samplingProfiler.hpp"
 
 #include "../src/immutable/common.hpp"
 #include "../src/immutable/pageRankComputer.hpp"
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "../src/immutable/common.hpp"
+#include "../src/instrumentation.hpp"
+#include "../src/multiThreadedPageRankComputer.hpp"
+#include "../src/singleThreadedPageRankComputer.hpp"
+
+#include "./lib/networkGenerator.hpp"
+#include "./lib/samplingProfiler.hpp"
+#include "./lib/simpleIdGenerator.hpp"
+
+// Instrumented runs report their iterations, residuals and phases.
+int main()
+{
+    std::vector<RunReport> reports;
+    Instrumentation::setSink([&reports](RunReport const& report) { reports.push_back(report); });
+
+    SimpleIdGenerator idGenerator("b7628d82a284526971095162ba34be8bc05c6e06b9face83b46c2813f7f2157b");
+    SimpleNetworkGenerator networkGenerator(idGenerator);
+    std::vector<std::shared_ptr<PageRankComputer>> computers = {
+        std::shared_ptr<PageRankComputer>(new SingleThreadedPageRankComputer {}),
+        std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 3 }),
+    };
+
+    double tolerance = 0.0000001;
+    for (auto computer : computers) {
+        auto result = computer->computeForNetwork(networkGenerator.generateNetworkOfSize(100), 0.85, 100, tolerance);
+        ASSERT(result.size() == 100, "Invalid result size=" << result.size());
+    }
+    ASSERT(reports.size() == computers.size(), "Invalid number of reports=" << reports.size());
+
+    for (auto const& report : reports) {
+        auto const& residuals = report.getResiduals();
+        ASSERT(report.getIterations() > 1 && residuals.back() < tolerance && residuals.front() >= tolerance,
+            "Invalid residuals, iterations=" << report.getIterations());
+        ASSERT(report.getPhaseSeconds(RunReport::edges) > 0 && report.getEdgesPerSecond() > 0, "Edge phase not measured");
+
+        std::ostringstream json;
+        report.writeJson(json);
+        ASSERT(json.str().front() == '{' && json.str().find("\"residuals\":[") != std::string::npos, "Invalid JSON=" << json.str());
+
+        std::ostringstream headerStream, rowStream;
+        RunReport::writeCsvHeader(headerStream);
+        report.writeCsv(rowStream);
+        std::string header = headerStream.str(), row = rowStream.str();
+        ASSERT(std::count(header.begin(), header.end(), ',') == std::count(row.begin(), row.end(), ','),
+            "CSV row does not match the header=" << header << ", row=" << row);
+    }
+
+    return 0;
+}
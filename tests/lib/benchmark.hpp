@@ -0,0 +1,286 @@
+#ifndef TESTS_LIB_BENCHMARK_HPP_
+#define TESTS_LIB_BENCHMARK_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../src/immutable/common.hpp"
+#include "hardwareCounters.hpp"
+
+// One repetition of a benchmark: the body times exactly one region with
+// time(), everything else it does (fresh inputs, checks) is not measured.
+class BenchmarkRun {
+public:
+    BenchmarkRun(HardwareCounters* hardwareCountersArg)
+        : seconds(-1)
+        , counters()
+        , hardwareCounters(hardwareCountersArg)
+        , hardwareCounts()
+    {
+    }
+
+    template <typename Func>
+    void time(Func const& func)
+    {
+        ASSERT(this->seconds < 0, "A benchmark run times one region only");
+        if (this->hardwareCounters != nullptr)
+            this->hardwareCounters->start();
+        auto start = std::chrono::steady_clock::now();
+        func();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        this->seconds = elapsed.count();
+        if (this->hardwareCounters != nullptr) {
+            this->hardwareCounters->stop();
+            this->hardwareCounts = this->hardwareCounters->read();
+        }
+    }
+
+    // Of the timed region, once time() returned.
+    double getSeconds() const
+    {
+        return this->seconds;
+    }
+
+    // Extra value reported with the benchmark (bytes, errors, ...), the one
+    // of the last repetition wins.
+    void counter(std::string const& name, double value)
+    {
+        this->counters[name] = value;
+    }
+
+private:
+    double seconds;
+    std::map<std::string, double> counters;
+    HardwareCounters* hardwareCounters;
+    std::vector<HardwareCounters::Count> hardwareCounts;
+
+    friend class BenchmarkSuite;
+};
+
+// Registered benchmarks run one after another: setup once (not timed), then
+// the body `warmup` times unrecorded and `repetitions` times recorded. A
+// summary goes to stdout and every sample with its statistics to a JSON
+// file, so builds can be compared benchmark by benchmark.
+//
+// Command line: --filter=<substring of names> --repetitions=<n> --warmup=<n>
+// --out=<json path> --counters. Without --out the JSON file goes next to the
+// executable, into the build directory.
+//
+// With --counters the timed regions also count CPU events (see
+// HardwareCounters), reported as medians over the repetitions under
+// "hardware", with instructions per cycle. Benchmarks with an "edges"
+// counter also get every event per edge of the graph, and with an
+// "iterations" counter too per edge and iteration (<event>PerEdgeIteration),
+// which tells compute bound kernels from memory bound ones.
+class BenchmarkSuite {
+public:
+    // Setup returns the body of a repetition. State it captures lives until
+    // the benchmark is done.
+    typedef std::function<void(BenchmarkRun&)> Body;
+    typedef std::function<Body()> Setup;
+
+    BenchmarkSuite(int argc, char** argv, std::string const& defaultOut)
+        : filter()
+        , warmup(1)
+        , repetitions(5)
+        , out(besideExecutable(argv[0], defaultOut))
+        , benchmarks()
+        , hardwareCounters()
+    {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument(argv[i]);
+            if (not parseOption(argument, "--filter=", this->filter) && not parseOption(argument, "--out=", this->out)) {
+                std::string number;
+                if (argument == "--counters")
+                    this->hardwareCounters.reset(new HardwareCounters());
+                else if (parseOption(argument, "--repetitions=", number))
+                    this->repetitions = std::stoul(number);
+                else if (parseOption(argument, "--warmup=", number))
+                    this->warmup = std::stoul(number);
+                else
+                    ASSERT(false, "Unknown argument=" << argument);
+            }
+        }
+        ASSERT(this->repetitions > 0, "At least one repetition needed");
+
+        if (this->hardwareCounters) {
+            for (auto const& name : HardwareCounters::unavailable())
+                std::cerr << "Counter unavailable: " << name << std::endl;
+            if (not this->hardwareCounters->isAvailable())
+                this->hardwareCounters.reset();
+        }
+    }
+
+    void add(std::string const& name, Setup const& setup)
+    {
+        this->benchmarks.push_back({ name, setup });
+    }
+
+    void run()
+    {
+        std::ofstream json(this->out);
+        ASSERT(json.good(), "Cannot write benchmark results=" << this->out);
+        json << "{\"context\":{\"date\":" << std::time(nullptr) << ",\"hardwareThreads\":" << std::thread::hardware_concurrency()
+             << ",\"optimized\":" << (isOptimized() ? "true" : "false") << ",\"warmup\":" << this->warmup
+             << ",\"repetitions\":" << this->repetitions << "},\"benchmarks\":[";
+
+        std::cout << std::left << std::setw(88) << "Benchmark" << std::right << std::setw(12) << "median" << std::setw(12)
+                  << "p10" << std::setw(12) << "p90" << std::setw(12) << "min" << "  counters" << std::endl;
+
+        bool first = true;
+        for (auto const& benchmark : this->benchmarks) {
+            if (benchmark.name.find(this->filter) == std::string::npos)
+                continue;
+
+            std::vector<double> samples;
+            std::map<std::string, double> counters;
+            std::map<std::string, std::vector<double>> hardwareSamples;
+            {
+                Body body = benchmark.setup();
+                for (uint32_t i = 0; i < this->warmup + this->repetitions; ++i) {
+                    BenchmarkRun run(this->hardwareCounters.get());
+                    body(run);
+                    ASSERT(run.seconds >= 0, "Benchmark=" << benchmark.name << " did not time anything");
+                    if (i >= this->warmup) {
+                        samples.push_back(run.seconds);
+                        for (auto const& count : run.hardwareCounts)
+                            hardwareSamples[count.name].push_back(count.value);
+                    }
+                    for (auto const& counter : run.counters)
+                        counters[counter.first] = counter.second;
+                }
+            }
+
+            auto hardware = summarizeHardware(hardwareSamples, counters);
+            printSummary(benchmark.name, samples, counters, hardware);
+            json << (first ? "" : ",") << "\n";
+            writeJson(json, benchmark.name, samples, counters, hardware);
+            first = false;
+        }
+        json << "\n]}" << std::endl;
+    }
+
+    // Nearest rank percentile of sorted samples, p in [0, 100].
+    static double percentile(std::vector<double> const& sorted, double p)
+    {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+        return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+    }
+
+private:
+    struct Benchmark {
+        std::string name;
+        Setup setup;
+    };
+
+    std::string filter;
+    uint32_t warmup;
+    uint32_t repetitions;
+    std::string out;
+    std::vector<Benchmark> benchmarks;
+    std::unique_ptr<HardwareCounters> hardwareCounters;
+
+    static bool parseOption(std::string const& argument, std::string const& prefix, std::string& value)
+    {
+        if (argument.compare(0, prefix.size(), prefix) != 0)
+            return false;
+        value = argument.substr(prefix.size());
+        return true;
+    }
+
+    // `name` in the directory of `executable`.
+    static std::string besideExecutable(char const* executable, std::string const& name)
+    {
+        std::string path(executable);
+        auto slash = path.rfind('/');
+        return slash == std::string::npos ? name : path.substr(0, slash + 1) + name;
+    }
+
+    static std::ostream& writeMap(std::ostream& json, std::map<std::string, double> const& values)
+    {
+        bool first = true;
+        for (auto const& value : values) {
+            json << (first ? "" : ",") << "\"" << value.first << "\":" << value.second;
+            first = false;
+        }
+        return json;
+    }
+
+    static bool isOptimized()
+    {
+#ifdef __OPTIMIZE__
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Median of every event, per edge when the benchmark counts edges, and
+    // per edge and iteration when it counts iterations as well.
+    static std::map<std::string, double> summarizeHardware(std::map<std::string, std::vector<double>> samples, std::map<std::string, double> const& counters)
+    {
+        std::map<std::string, double> hardware;
+        for (auto& event : samples) {
+            std::sort(event.second.begin(), event.second.end());
+            hardware[event.first] = percentile(event.second, 50);
+        }
+        if (hardware.count("cycles") && hardware.count("instructions") && hardware["cycles"] > 0)
+            hardware["instructionsPerCycle"] = hardware["instructions"] / hardware["cycles"];
+
+        auto edges = counters.find("edges");
+        auto iterations = counters.find("iterations");
+        if (edges != counters.end() && edges->second > 0) {
+            bool iterated = iterations != counters.end() && iterations->second > 0;
+            double visits = iterated ? edges->second * iterations->second : edges->second;
+            for (auto const& event : samples)
+                hardware[event.first + (iterated ? "PerEdgeIteration" : "PerEdge")] = hardware[event.first] / visits;
+        }
+        return hardware;
+    }
+
+    static void printSummary(std::string const& name, std::vector<double> samples, std::map<std::string, double> const& counters,
+        std::map<std::string, double> const& hardware)
+    {
+        std::sort(samples.begin(), samples.end());
+        std::cout << std::left << std::setw(88) << name << std::right << std::setprecision(4);
+        for (double value : { percentile(samples, 50), percentile(samples, 10), percentile(samples, 90), samples.front() })
+            std::cout << std::setw(11) << value << "s";
+        std::cout << std::setprecision(10) << " ";
+        for (auto const& counter : counters)
+            std::cout << " " << counter.first << "=" << counter.second;
+        std::cout << std::setprecision(4);
+        for (auto const& event : hardware)
+            std::cout << " " << event.first << "=" << event.second;
+        std::cout << std::setprecision(6) << std::endl;
+    }
+
+    static void writeJson(std::ostream& json, std::string const& name, std::vector<double> const& samples, std::map<std::string, double> const& counters,
+        std::map<std::string, double> const& hardware)
+    {
+        std::vector<double> sorted(samples);
+        std::sort(sorted.begin(), sorted.end());
+        double mean = 0;
+        for (double sample : samples)
+            mean += sample / samples.size();
+
+        json << std::setprecision(9) << "{\"name\":\"" << name << "\",\"seconds\":[";
+        printContainer(json, samples) << "],\"min\":" << sorted.front() << ",\"p10\":" << percentile(sorted, 10)
+                                      << ",\"median\":" << percentile(sorted, 50) << ",\"p90\":" << percentile(sorted, 90)
+                                      << ",\"max\":" << sorted.back() << ",\"mean\":" << mean << ",\"counters\":{";
+        writeMap(json, counters) << "},\"hardware\":{";
+        writeMap(json, hardware) << "}}";
+    }
+};
+
+#endif /* TESTS_LIB_BENCHMARK_HPP_ */
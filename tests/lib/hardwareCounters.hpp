@@ -0,0 +1,144 @@
+#ifndef TESTS_LIB_HARDWARECOUNTERS_HPP_
+#define TESTS_LIB_HARDWARECOUNTERS_HPP_
+
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+// perf_event counters of the calling thread and of every thread and process
+// it starts while counting (inherited counts are added when those exit, so
+// they have to be joined before read()). Events the kernel, the CPU or the
+// container refuse (hardware events usually are in containers and VMs) are
+// left out, so any subset of them, possibly none, is available.
+class HardwareCounters {
+public:
+    struct Count {
+        std::string name;
+        double value;
+    };
+
+    HardwareCounters()
+        : events()
+    {
+        for (auto const& event : eventTypes()) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = event.type;
+            attr.config = event.config;
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+            if (fd >= 0)
+                this->events.push_back({ event.name, fd, { 0, 0, 0 } });
+            else
+                unavailable().push_back(std::string(event.name) + " (" + std::strerror(errno) + ")");
+        }
+    }
+
+    HardwareCounters(HardwareCounters const&) = delete;
+    HardwareCounters& operator=(HardwareCounters const&) = delete;
+
+    ~HardwareCounters()
+    {
+        for (auto const& event : this->events)
+            close(event.fd);
+    }
+
+    bool isAvailable() const
+    {
+        return not this->events.empty();
+    }
+
+    // Counting restarts from the current values: PERF_EVENT_IOC_RESET does
+    // not clear the counts of exited threads.
+    void start()
+    {
+        for (auto& event : this->events) {
+            readValues(event, event.start);
+            ioctl(event.fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    void stop()
+    {
+        for (auto const& event : this->events)
+            ioctl(event.fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    // Counts since start(), scaled up when the kernel multiplexed an event.
+    std::vector<Count> read() const
+    {
+        std::vector<Count> counts;
+        for (auto const& event : this->events) {
+            Values end;
+            if (not readValues(event, end) || end.running == event.start.running)
+                continue;
+            double enabled = end.enabled - event.start.enabled;
+            double running = end.running - event.start.running;
+            counts.push_back({ event.name, (end.value - event.start.value) * enabled / running });
+        }
+        return counts;
+    }
+
+    // Events left out so far, with the reason.
+    static std::vector<std::string>& unavailable()
+    {
+        static std::vector<std::string> names;
+        return names;
+    }
+
+private:
+    struct EventType {
+        char const* name;
+        uint32_t type;
+        uint64_t config;
+    };
+
+    // Layout of read() with the TOTAL_TIME_ENABLED and TOTAL_TIME_RUNNING formats.
+    struct Values {
+        uint64_t value;
+        uint64_t enabled;
+        uint64_t running;
+    };
+
+    struct Event {
+        std::string name;
+        int fd;
+        Values start;
+    };
+
+    std::vector<Event> events;
+
+    static bool readValues(Event const& event, Values& values)
+    {
+        return ::read(event.fd, &values, sizeof(values)) == sizeof(values);
+    }
+
+    static std::vector<EventType> const& eventTypes()
+    {
+        static std::vector<EventType> const types = {
+            { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { "llcMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+            { "branchMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { "dtlbMisses", PERF_TYPE_HW_CACHE,
+                PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+            // Software events, available wherever perf_event_open is.
+            { "taskClockNs", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+            { "pageFaults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+        };
+        return types;
+    }
+};
+
+#endif /* TESTS_LIB_HARDWARECOUNTERS_HPP_ */
@@ -1,7 +1,13 @@
 #ifndef NETWORK_GENERATOR
 #define NETWORK_GENERATOR
 
+#include <cmath>
+#include <memory>
+#include <random>
+
 #include "../../src/immutable/network.hpp"
+#include "../../src/parallelUtils.hpp"
+#include "../../src/preparedGraph.hpp"
 
 class NetworkGenerator {
 public:
@@ -98,6 +104,341 @@ public:
     }
 };
 
+// SplitMix64, a small and fast generator usable with the <random>
+// distributions. Every (seed, stream) pair gives an unrelated sequence.
+class SplitMix64 {
+public:
+    typedef uint64_t result_type;
+
+    SplitMix64(uint64_t seed, uint64_t stream)
+        : state(seed)
+    {
+        this->state = (*this)() ^ stream;
+        this->state = (*this)();
+    }
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return UINT64_MAX; }
+
+    uint64_t operator()()
+    {
+        uint64_t z = (this->state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, bound).
+    uint64_t below(uint64_t bound)
+    {
+        return (*this)() % bound;
+    }
+
+    // Uniform in [0, 1).
+    double uniform()
+    {
+        return ((*this)() >> 11) / 9007199254740992.0;
+    }
+
+private:
+    uint64_t state;
+};
+
+// Random networks of pages "0", "1", ..., whose links generateLinks() draws
+// from the seed and the page only, so the same network comes out for any
+// number of threads. Pages never link to themselves.
+class RandomNetworkGenerator : public NetworkGenerator {
+public:
+    RandomNetworkGenerator(IdGenerator const& idGeneratorArg, uint64_t seedArg, uint32_t numThreadsArg)
+        : NetworkGenerator(idGeneratorArg)
+        , seed(seedArg)
+        , numThreads(numThreadsArg)
+    {
+    }
+
+    virtual Network generateNetworkOfSize(uint32_t const size) const
+    {
+        std::vector<PageId> ids = this->generateIds(size);
+        std::vector<std::vector<Page>> threadPages(this->numThreads);
+        runInParallel(this->numThreads, [&](uint32_t thread) {
+            std::vector<PageIndex> links;
+            auto end = segmentEnd(size, this->numThreads, thread);
+            for (auto i = segmentBegin(size, this->numThreads, thread); i < end; ++i) {
+                Page page = this->generatePageFromNum(i);
+                this->generateLinks(size, i, links);
+                for (auto link : links)
+                    page.addLink(ids[link]);
+                threadPages[thread].push_back(std::move(page));
+            }
+        });
+
+        Network network(this->idGenerator);
+        for (auto const& pages : threadPages)
+            for (auto const& page : pages)
+                network.addPage(page);
+        return network;
+    }
+
+    // The network of generateNetworkOfSize(size) emitted straight into a
+    // PreparedGraph, without pages and link ids, for graphs too big to be
+    // built page by page.
+    std::unique_ptr<PreparedGraph> generateGraphOfSize(uint32_t const size) const
+    {
+        std::vector<PageId> ids = this->generateIds(size);
+        std::vector<uint32_t> numLinks(size, 0);
+        CsrGraphBuilder builder(size, this->numThreads);
+        runInParallel(this->numThreads, [&](uint32_t thread) {
+            std::vector<PageIndex> links;
+            auto end = segmentEnd(size, this->numThreads, thread);
+            for (auto i = segmentBegin(size, this->numThreads, thread); i < end; ++i) {
+                this->generateLinks(size, i, links);
+                numLinks[i] = links.size();
+                for (auto link : links)
+                    builder.addEdge(thread, i, link);
+            }
+        });
+        return std::unique_ptr<PreparedGraph>(new PreparedGraph(ids, std::move(numLinks), builder.build(), this->numThreads));
+    }
+
+protected:
+    uint64_t seed;
+    uint32_t numThreads;
+
+    // Replaces `links` with the targets of the links of `page` in a network of `size` pages.
+    virtual void generateLinks(uint32_t size, PageIndex page, std::vector<PageIndex>& links) const = 0;
+
+private:
+    std::vector<PageId> generateIds(uint32_t size) const
+    {
+        std::vector<PageId> ids(size, PageId(""));
+        runInParallel(this->numThreads, [&](uint32_t thread) {
+            auto end = segmentEnd(size, this->numThreads, thread);
+            for (auto i = segmentBegin(size, this->numThreads, thread); i < end; ++i)
+                ids[i] = this->generatePageFromNumWithGeneratedId(i).getId();
+        });
+        return ids;
+    }
+};
+
+// Erdős–Rényi G(n, p): every ordered pair of distinct pages is a link with
+// probability averageDegree / (size - 1). Gaps between the links of a page
+// are drawn from a geometric distribution, so a page costs its links only.
+class ErdosRenyiNetworkGenerator : public RandomNetworkGenerator {
+public:
+    ErdosRenyiNetworkGenerator(IdGenerator const& idGeneratorArg, double averageDegreeArg, uint64_t seedArg = 2021, uint32_t numThreadsArg = 1)
+        : RandomNetworkGenerator(idGeneratorArg, seedArg, numThreadsArg)
+        , averageDegree(averageDegreeArg)
+    {
+        ASSERT(averageDegreeArg > 0, "Invalid averageDegree=" << averageDegreeArg);
+    }
+
+protected:
+    virtual void generateLinks(uint32_t size, PageIndex page, std::vector<PageIndex>& links) const
+    {
+        links.clear();
+        if (size < 2)
+            return;
+
+        SplitMix64 random(this->seed, page);
+        std::geometric_distribution<uint64_t> gap(std::min(1.0, this->averageDegree / (size - 1)));
+        // Candidate c stands for page c, or c + 1 from `page` on.
+        for (uint64_t candidate = gap(random); candidate < size - 1; candidate += 1 + gap(random))
+            links.push_back(candidate + (candidate >= page));
+    }
+
+private:
+    double averageDegree;
+};
+
+// R-MAT, the recursive matrix generator of Graph500: a cell of the 2^scale x
+// 2^scale adjacency matrix is picked by choosing quadrants with probabilities
+// a, b, c and 1 - a - b - c down to a single cell, which gives skewed in- and
+// out-degrees. Drawn per page rather than per link: page u gets a Poisson
+// number of links around its share of size * averageDegree, its row
+// probability being the product of the row choices of its bits, and every
+// target bit is drawn given the matching bit of u. Targets outside the
+// network or equal to u are drawn again, parallel links are kept.
+class RmatNetworkGenerator : public RandomNetworkGenerator {
+public:
+    RmatNetworkGenerator(IdGenerator const& idGeneratorArg, double averageDegreeArg, uint64_t seedArg = 2021, uint32_t numThreadsArg = 1,
+        double aArg = 0.57, double bArg = 0.19, double cArg = 0.19)
+        : RandomNetworkGenerator(idGeneratorArg, seedArg, numThreadsArg)
+        , averageDegree(averageDegreeArg)
+        , a(aArg)
+        , b(bArg)
+        , c(cArg)
+    {
+        ASSERT(averageDegreeArg > 0, "Invalid averageDegree=" << averageDegreeArg);
+        ASSERT(aArg > 0 && bArg > 0 && cArg > 0 && aArg + bArg + cArg < 1, "Invalid quadrant probabilities a=" << aArg << ", b=" << bArg << ", c=" << cArg);
+    }
+
+protected:
+    virtual void generateLinks(uint32_t size, PageIndex page, std::vector<PageIndex>& links) const
+    {
+        links.clear();
+        if (size < 2)
+            return;
+
+        uint32_t scale = 0;
+        while ((uint64_t(1) << scale) < size)
+            ++scale;
+
+        // Probability of the row of `page`, and of all rows below size.
+        double top = this->a + this->b;
+        double rowProbability = 1, rowsBelowSize = 0, prefixProbability = 1;
+        for (uint32_t bit = scale; bit-- > 0;) {
+            rowProbability *= (page >> bit & 1) ? 1 - top : top;
+            if (size >> bit & 1) {
+                rowsBelowSize += prefixProbability * top;
+                prefixProbability *= 1 - top;
+            } else {
+                prefixProbability *= top;
+            }
+        }
+
+        SplitMix64 random(this->seed, page);
+        double mean = double(size) * this->averageDegree * rowProbability / rowsBelowSize;
+        uint32_t numLinks = std::poisson_distribution<uint32_t>(mean)(random);
+        // Probability of a right half column, in the top and in the bottom half rows.
+        double rightGivenTop = this->b / top;
+        double rightGivenBottom = (1 - top - this->c) / (1 - top);
+        while (links.size() < numLinks) {
+            uint64_t target = 0;
+            for (uint32_t bit = scale; bit-- > 0;) {
+                bool right = random.uniform() < ((page >> bit & 1) ? rightGivenBottom : rightGivenTop);
+                target |= uint64_t(right) << bit;
+            }
+            if (target < size && target != page)
+                links.push_back(target);
+        }
+    }
+
+private:
+    double averageDegree;
+    double a;
+    double b;
+    double c;
+};
+
+// Barabási–Albert preferential attachment: page i links to
+// min(linksPerPage, i) distinct earlier pages. A link goes to a uniformly
+// random earlier page with probability 1/2 and otherwise to the first draw of
+// a uniformly random earlier link, so pages are picked in proportion to their
+// in-degree plus one and in-degrees follow a power law. Every draw has a
+// generator of its own, so the target of an earlier link is drawn again
+// instead of looked up (as done by Sanders and Schulz) and pages do not
+// depend on each other.
+class BarabasiAlbertNetworkGenerator : public RandomNetworkGenerator {
+public:
+    BarabasiAlbertNetworkGenerator(IdGenerator const& idGeneratorArg, uint32_t linksPerPageArg, uint64_t seedArg = 2021, uint32_t numThreadsArg = 1)
+        : RandomNetworkGenerator(idGeneratorArg, seedArg, numThreadsArg)
+        , linksPerPage(linksPerPageArg)
+    {
+        ASSERT(linksPerPageArg > 0, "Invalid linksPerPage=" << linksPerPageArg);
+    }
+
+protected:
+    virtual void generateLinks(uint32_t, PageIndex page, std::vector<PageIndex>& links) const
+    {
+        links.clear();
+        uint64_t firstLink = this->linksBefore(page);
+        for (uint32_t j = 0; j < std::min(this->linksPerPage, page); ++j) {
+            PageIndex target;
+            uint32_t attempt = 0;
+            do
+                target = this->drawTarget(page, firstLink + j, attempt++);
+            while (std::find(links.begin(), links.end(), target) != links.end());
+            links.push_back(target);
+        }
+    }
+
+private:
+    uint32_t linksPerPage;
+
+    // Links of the pages before `page`, which is also the number of the first link of `page`.
+    uint64_t linksBefore(PageIndex page) const
+    {
+        uint64_t m = this->linksPerPage;
+        if (page <= m)
+            return uint64_t(page) * (page - 1) / 2;
+        return m * (m - 1) / 2 + (page - m) * m;
+    }
+
+    // Page whose links include link number `link`.
+    PageIndex pageOfLink(uint64_t link) const
+    {
+        uint64_t m = this->linksPerPage;
+        if (link >= m * (m - 1) / 2)
+            return m + (link - m * (m - 1) / 2) / m;
+        PageIndex page = 1;
+        while (this->linksBefore(page + 1) <= link)
+            ++page;
+        return page;
+    }
+
+    PageIndex drawTarget(PageIndex page, uint64_t link, uint32_t attempt) const
+    {
+        while (true) {
+            SplitMix64 random(this->seed + attempt * 0x9e3779b97f4a7c15ULL, link);
+            uint64_t earlierLinks = this->linksBefore(page);
+            if (earlierLinks == 0 || random() & 1)
+                return random.below(page);
+            // Copy the first draw of an earlier link.
+            link = random.below(earlierLinks);
+            page = this->pageOfLink(link);
+            attempt = 0;
+        }
+    }
+};
+
+// Chains of clusters of clusterSize consecutive pages: a page links to the
+// next page of its cluster, closing a cycle, and to linksPerPage - 1 random
+// pages, each with probability 1/2 of its own cluster and otherwise of the
+// next `span` clusters. Every cluster is strongly connected and clusters only
+// link forward, a DAG of components as deep as there are clusters.
+class ClusterChainNetworkGenerator : public RandomNetworkGenerator {
+public:
+    ClusterChainNetworkGenerator(IdGenerator const& idGeneratorArg, uint32_t linksPerPageArg, uint32_t clusterSizeArg, uint32_t spanArg = 4,
+        uint64_t seedArg = 2021, uint32_t numThreadsArg = 1)
+        : RandomNetworkGenerator(idGeneratorArg, seedArg, numThreadsArg)
+        , linksPerPage(linksPerPageArg)
+        , clusterSize(clusterSizeArg)
+        , span(spanArg)
+    {
+        ASSERT(linksPerPageArg > 0 && clusterSizeArg > 0, "Invalid linksPerPage=" << linksPerPageArg << ", clusterSize=" << clusterSizeArg);
+    }
+
+protected:
+    virtual void generateLinks(uint32_t size, PageIndex page, std::vector<PageIndex>& links) const
+    {
+        links.clear();
+        uint64_t clusterBegin = page / this->clusterSize * uint64_t(this->clusterSize);
+        uint64_t clusterEnd = std::min<uint64_t>(size, clusterBegin + this->clusterSize);
+        uint64_t forwardEnd = std::min<uint64_t>(size, clusterEnd + uint64_t(this->span) * this->clusterSize);
+        bool inside = clusterEnd - clusterBegin > 1;
+        if (inside)
+            links.push_back(page + 1 < clusterEnd ? page + 1 : clusterBegin);
+        if (not inside && forwardEnd == clusterEnd)
+            return;
+
+        SplitMix64 random(this->seed, page);
+        while (links.size() < this->linksPerPage) {
+            if (forwardEnd > clusterEnd && (not inside || random() & 1)) {
+                links.push_back(clusterEnd + random.below(forwardEnd - clusterEnd));
+            } else {
+                // Any other page of the cluster.
+                uint64_t target = clusterBegin + random.below(clusterEnd - clusterBegin - 1);
+                links.push_back(target + (target >= page));
+            }
+        }
+    }
+
+private:
+    uint32_t linksPerPage;
+    uint32_t clusterSize;
+    uint32_t span;
+};
+
 class StdinGenerator : public NetworkGenerator {
 public:
     StdinGenerator(IdGenerator const& idGeneratorArg)
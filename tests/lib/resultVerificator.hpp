@@ -1,6 +1,8 @@
 #ifndef RESULT_COMPARATOR_HPP_
 #define RESULT_COMPARATOR_HPP_
 
+#include <algorithm>
+#include <functional>
 #include <set>
 #include <vector>
 
@@ -51,6 +53,44 @@ public:
         verifyResults(set1, set2);
     }
 
+    // Rank of the page generated from every num in [0, size), 0 for pages missing from `result`.
+    static std::vector<PageRank> ranksByPageNum(std::vector<PageIdAndRank> const& result, uint32_t size, NetworkGenerator const& generator)
+    {
+        std::set<PageIdAndRankComparable> resultSet(result.begin(), result.end());
+        std::vector<PageRank> ranks(size, 0);
+        for (uint32_t i = 0; i < size; ++i) {
+            auto iter = resultSet.find(PageIdAndRank(generator.generatePageFromNumWithGeneratedId(i).getId(), 0));
+            if (iter != resultSet.end()) {
+                ranks[i] = iter->getPageRank();
+            }
+        }
+        return ranks;
+    }
+
+    static void verifyTopK(std::vector<PageIdAndRank> const& topK, std::vector<PageRank> const& expected, uint32_t k, NetworkGenerator const& generator)
+    {
+        ASSERT(topK.size() == std::min<size_t>(k, expected.size()), "Unexpected top size=" << topK.size() << ", k=" << k);
+
+        std::vector<PageRank> expectedSorted(expected);
+        std::sort(expectedSorted.begin(), expectedSorted.end(), std::greater<PageRank>());
+
+        std::set<PageIdAndRankComparable> expectedSet;
+        for (uint32_t i = 0; i < expected.size(); ++i) {
+            expectedSet.insert(PageIdAndRank(generator.generatePageFromNumWithGeneratedId(i).getId(), expected[i]));
+        }
+
+        for (uint32_t i = 0; i < topK.size(); ++i) {
+            PageIdAndRankComparable comparable(topK[i]);
+            auto iter = expectedSet.find(comparable);
+            ASSERT(iter != expectedSet.end(), "Unknown pageId=" << comparable.getPageId());
+            ASSERT(std::abs(iter->getPageRank() - comparable.getPageRank()) < 0.001,
+                "Invalid result, pageId=" << comparable.getPageId() << ", res1=" << comparable.getPageRank() << ", res2=" << iter->getPageRank());
+            // Equal ranks may come in any order, so only compare the values at each position.
+            ASSERT(std::abs(expectedSorted[i] - comparable.getPageRank()) < 0.001,
+                "Invalid rank at position=" << i << ", res1=" << comparable.getPageRank() << ", res2=" << expectedSorted[i]);
+        }
+    }
+
     static void verifyResults(std::set<PageIdAndRankComparable> const& set1, std::set<PageIdAndRankComparable> const& set2)
     {
         ASSERT(set1.size() == set2.size(), "Unexpected sizes: set1=" << set1.size() << ", set2=" << set2.size());
@@ -0,0 +1,305 @@
+#ifndef TESTS_LIB_SAMPLINGPROFILER_HPP_
+#define TESTS_LIB_SAMPLINGPROFILER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <map>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../../src/immutable/common.hpp"
+
+// In-process sampling profiler writing folded stacks, the input of
+// FlameGraph/flamegraph.pl. Started before main() when the PAGERANK_PROFILE
+// environment variable names the output file, PAGERANK_PROFILE_HZ sets the
+// rate (1000 by default). Every test binary including this header can be
+// profiled, see utils/profileProgram.sh.
+//
+// Samples are SIGPROF signals, one per 1/hz seconds of CPU time of a thread,
+// so only running threads are sampled. They come from a perf_event task
+// clock opened for every thread (threads are picked up by scanning
+// /proc/self/task every few milliseconds), or, when perf_event_open is not
+// allowed, from an ITIMER_PROF timer of the whole process (no faster than
+// the kernel tick). The handler only stores the backtrace in a preallocated
+// ring, a thread of the profiler folds the ring into counts. Forked
+// processes are not profiled.
+//
+// Function names come from the dynamic symbol table, so binaries are linked
+// with -rdynamic. Frames without a symbol show as module+offset.
+class SamplingProfiler {
+public:
+    static bool startFromEnvironment()
+    {
+        char const* path = std::getenv("PAGERANK_PROFILE");
+        if (path == nullptr)
+            return false;
+        char const* hz = std::getenv("PAGERANK_PROFILE_HZ");
+        instance().start(path, hz == nullptr ? 1000 : std::stoul(hz));
+        return true;
+    }
+
+    ~SamplingProfiler()
+    {
+        if (this->running)
+            this->stop();
+    }
+
+private:
+    static constexpr uint32_t maxFrames = 64;
+    static constexpr uint64_t ringSize = 1 << 14;
+    // Frames of the signal handler and of the signal trampoline.
+    static constexpr int skippedFrames = 2;
+
+    struct Sample {
+        std::atomic<bool> ready;
+        int numFrames;
+        void* frames[maxFrames];
+    };
+
+    std::string path;
+    uint32_t hz;
+    bool running;
+    bool usePerfEvents;
+    std::atomic<bool> stopping;
+    std::thread folder;
+
+    std::vector<Sample> ring;
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> numDropped;
+
+    // Only touched by the folder thread until it is joined.
+    std::map<std::vector<void*>, uint64_t> counts;
+    std::map<pid_t, int> perfEvents;
+
+    SamplingProfiler()
+        : path()
+        , hz(0)
+        , running(false)
+        , usePerfEvents(false)
+        , stopping(false)
+        , folder()
+        , ring(ringSize)
+        , head(0)
+        , tail(0)
+        , numDropped(0)
+        , counts()
+        , perfEvents()
+    {
+    }
+
+    static SamplingProfiler& instance()
+    {
+        static SamplingProfiler profiler;
+        return profiler;
+    }
+
+    void start(std::string const& pathArg, uint32_t hzArg)
+    {
+        ASSERT(not this->running, "Profiler started twice");
+        ASSERT(hzArg > 0, "Invalid PAGERANK_PROFILE_HZ=" << hzArg);
+        this->path = pathArg;
+        this->hz = hzArg;
+
+        // The first backtrace() loads the unwinder, which must not happen
+        // inside the signal handler.
+        void* frames[1];
+        backtrace(frames, 1);
+
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_sigaction = &SamplingProfiler::handleSignal;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        ASSERT(sigaction(SIGPROF, &action, nullptr) == 0, "Cannot install the SIGPROF handler");
+
+        this->running = true;
+        this->usePerfEvents = this->openPerfEvent(syscall(SYS_gettid));
+        if (not this->usePerfEvents) {
+            struct itimerval timer;
+            timer.it_interval.tv_sec = 0;
+            timer.it_interval.tv_usec = std::max<long>(1, 1000000 / hzArg);
+            timer.it_value = timer.it_interval;
+            ASSERT(setitimer(ITIMER_PROF, &timer, nullptr) == 0, "Cannot start the profiling timer");
+        }
+        this->folder = std::thread([this] { this->foldLoop(); });
+    }
+
+    void stop()
+    {
+        if (not this->usePerfEvents) {
+            struct itimerval timer;
+            std::memset(&timer, 0, sizeof(timer));
+            setitimer(ITIMER_PROF, &timer, nullptr);
+        }
+        this->stopping = true;
+        this->folder.join();
+        for (auto const& event : this->perfEvents)
+            close(event.second);
+        signal(SIGPROF, SIG_IGN);
+        this->running = false;
+        this->fold();
+        this->write();
+    }
+
+    static void handleSignal(int, siginfo_t*, void*)
+    {
+        int savedErrno = errno;
+        SamplingProfiler& profiler = instance();
+        uint64_t slot = profiler.head.load(std::memory_order_relaxed);
+        do {
+            if (slot - profiler.tail.load(std::memory_order_acquire) >= ringSize) {
+                profiler.numDropped.fetch_add(1, std::memory_order_relaxed);
+                errno = savedErrno;
+                return;
+            }
+        } while (not profiler.head.compare_exchange_weak(slot, slot + 1, std::memory_order_relaxed));
+
+        Sample& sample = profiler.ring[slot % ringSize];
+        sample.numFrames = backtrace(sample.frames, maxFrames);
+        sample.ready.store(true, std::memory_order_release);
+        errno = savedErrno;
+    }
+
+    // Task clock of thread tid, signalling that thread on every period.
+    bool openPerfEvent(pid_t tid)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_SOFTWARE;
+        attr.config = PERF_COUNT_SW_TASK_CLOCK;
+        attr.sample_period = 1000000000 / this->hz;
+        attr.wakeup_events = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        int fd = syscall(SYS_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (fd < 0)
+            return false;
+        f_owner_ex owner { F_OWNER_TID, tid };
+        if (fcntl(fd, F_SETFL, O_ASYNC | O_NONBLOCK) != 0 || fcntl(fd, F_SETSIG, SIGPROF) != 0 || fcntl(fd, F_SETOWN_EX, &owner) != 0) {
+            close(fd);
+            return false;
+        }
+        this->perfEvents[tid] = fd;
+        return true;
+    }
+
+    // Opens events for new threads and closes the ones of finished threads.
+    void scanThreads()
+    {
+        DIR* tasks = opendir("/proc/self/task");
+        if (tasks == nullptr)
+            return;
+        std::map<pid_t, int> alive;
+        while (dirent* entry = readdir(tasks)) {
+            if (entry->d_name[0] == '.')
+                continue;
+            pid_t tid = std::atoi(entry->d_name);
+            auto event = this->perfEvents.find(tid);
+            if (event != this->perfEvents.end() || this->openPerfEvent(tid))
+                alive[tid] = this->perfEvents[tid];
+        }
+        closedir(tasks);
+        for (auto const& event : this->perfEvents)
+            if (alive.count(event.first) == 0)
+                close(event.second);
+        this->perfEvents.swap(alive);
+    }
+
+    void foldLoop()
+    {
+        while (not this->stopping) {
+            if (this->usePerfEvents)
+                this->scanThreads();
+            this->fold();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    void fold()
+    {
+        uint64_t slot = this->tail.load(std::memory_order_relaxed);
+        while (true) {
+            Sample& sample = this->ring[slot % ringSize];
+            if (not sample.ready.load(std::memory_order_acquire))
+                break;
+            if (sample.numFrames > skippedFrames)
+                ++this->counts[std::vector<void*>(sample.frames + skippedFrames, sample.frames + sample.numFrames)];
+            sample.ready.store(false, std::memory_order_relaxed);
+            this->tail.store(++slot, std::memory_order_release);
+        }
+    }
+
+    // One "outermost;...;innermost count" line per distinct stack.
+    void write()
+    {
+        std::ofstream out(this->path);
+        ASSERT(out.good(), "Cannot write PAGERANK_PROFILE=" << this->path);
+
+        std::map<void*, std::string> names;
+        uint64_t numSamples = 0;
+        for (auto const& stack : this->counts) {
+            for (size_t f = stack.first.size(); f-- > 0;) {
+                // Outer frames hold return addresses, which may already be
+                // past the end of the calling function.
+                void* address = static_cast<char*>(stack.first[f]) - (f == 0 ? 0 : 1);
+                auto name = names.find(address);
+                if (name == names.end())
+                    name = names.insert({ address, symbolName(address) }).first;
+                out << name->second << (f == 0 ? " " : ";");
+            }
+            out << stack.second << "\n";
+            numSamples += stack.second;
+        }
+        std::cerr << "Profile: " << numSamples << " samples at " << this->hz << " Hz (" << (this->usePerfEvents ? "perf_event" : "timer")
+                  << "), " << this->numDropped << " dropped, written to " << this->path << std::endl;
+    }
+
+    static std::string symbolName(void* address)
+    {
+        Dl_info info;
+        if (dladdr(address, &info) == 0)
+            return "[unknown]";
+        std::string name;
+        if (info.dli_sname != nullptr) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            name = status == 0 ? demangled : info.dli_sname;
+            std::free(demangled);
+        } else {
+            char offset[32];
+            std::snprintf(offset, sizeof(offset), "+0x%lx", static_cast<unsigned long>(static_cast<char*>(address) - static_cast<char*>(info.dli_fbase)));
+            std::string module(info.dli_fname == nullptr ? "[unknown]" : info.dli_fname);
+            name = module.substr(module.rfind('/') + 1) + offset;
+        }
+        // ';' separates frames in folded stacks.
+        for (auto& c : name)
+            if (c == ';')
+                c = ':';
+        return name;
+    }
+};
+
+// Checks the environment before main() runs.
+static bool const samplingProfilerStarted = SamplingProfiler::startFromEnvironment();
+
+#endif /* TESTS_LIB_SAMPLINGPROFILER_HPP_ */
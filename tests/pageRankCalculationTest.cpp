@@ -1,13 +1,27 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 #include "../src/immutable/common.hpp"
 #include "../src/immutable/pageIdAndRank.hpp"
+#include "../src/autoPageRankComputer.hpp"
+#include "../src/distributedPageRankComputer.hpp"
+#include "../src/lumpedPageRankComputer.hpp"
+#include "../src/monteCarloPageRankComputer.hpp"
 #include "../src/multiThreadedPageRankComputer.hpp"
+#include "../src/personalizedPageRankComputer.hpp"
+#include "../src/presolvedGraph.hpp"
+#include "../src/rankingScheduler.hpp"
+#include "../src/sccDecomposition.hpp"
+#include "../src/sccPageRankComputer.hpp"
 #include "../src/singleThreadedPageRankComputer.hpp"
 
 #include "./lib/networkGenerator.hpp"
 #include "./lib/resultVerificator.hpp"
+#include "./lib/samplingProfiler.hpp"
 #include "./lib/simpleIdGenerator.hpp"
 
 struct TestScenario {
@@ -37,6 +51,21 @@ int main()
         std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 7 }),
         std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 8 }),
         std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 9 }),
+        std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 1, true }),
+        std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 3, true }),
+        std::shared_ptr<PageRankComputer>(new DistributedPageRankComputer { 1 }),
+        std::shared_ptr<PageRankComputer>(new DistributedPageRankComputer { 2 }),
+        std::shared_ptr<PageRankComputer>(new DistributedPageRankComputer { 3 }),
+        std::shared_ptr<PageRankComputer>(new DistributedPageRankComputer { 4 }),
+        std::shared_ptr<PageRankComputer>(new MonteCarloPageRankComputer { 1, 500000 }),
+        std::shared_ptr<PageRankComputer>(new MonteCarloPageRankComputer { 4, 500000 }),
+        std::shared_ptr<PageRankComputer>(new LumpedPageRankComputer { 1 }),
+        std::shared_ptr<PageRankComputer>(new LumpedPageRankComputer { 3 }),
+        std::shared_ptr<PageRankComputer>(new LumpedPageRankComputer { 3, false }),
+        std::shared_ptr<PageRankComputer>(new SccPageRankComputer { 1 }),
+        std::shared_ptr<PageRankComputer>(new SccPageRankComputer { 3 }),
+        std::shared_ptr<PageRankComputer>(new AutoPageRankComputer {}),
+        std::shared_ptr<PageRankComputer>(new AutoPageRankComputer { { 3, AutoPageRankComputer::Kernel::compressed } }),
     };
 
     SimpleIdGenerator idGenerator("b7628d82a284526971095162ba34be8bc05c6e06b9face83b46c2813f7f2157b");
@@ -51,9 +80,430 @@ int main()
                 scenario.iterations,
                 scenario.tolerance);
             ResultVerificator::verifyResults(result, scenario.expectedResult, networkGenerator);
+
+            uint32_t k = 3;
+            auto topK = computer->computeTopK(
+                networkGenerator.generateNetworkOfSize(scenario.numberOfNodes),
+                scenario.alpha,
+                scenario.iterations,
+                scenario.tolerance,
+                k);
+            ResultVerificator::verifyTopK(topK, scenario.expectedResult, k, networkGenerator);
+
+            // A network and a graph prepared from it can be run repeatedly.
+            auto network = networkGenerator.generateNetworkOfSize(scenario.numberOfNodes);
+            PreparedGraph graph(network, 2);
+            for (uint32_t run = 0; run < 2; ++run) {
+                ResultVerificator::verifyResults(
+                    computer->computeForGraph(graph, scenario.alpha, scenario.iterations, scenario.tolerance),
+                    scenario.expectedResult, networkGenerator);
+                ResultVerificator::verifyResults(
+                    computer->computeForNetwork(network, scenario.alpha, scenario.iterations, scenario.tolerance),
+                    scenario.expectedResult, networkGenerator);
+            }
+            ResultVerificator::verifyTopK(
+                computer->computeTopKForGraph(graph, scenario.alpha, scenario.iterations, scenario.tolerance, k),
+                scenario.expectedResult, k, networkGenerator);
             // std::cout << "Scenario finished with successed" << std::endl;
         }
     }
 
+    // Threads preparing the same network at once generate every id once.
+    {
+        auto scenario = scenarios.back();
+        auto network = networkGenerator.generateNetworkOfSize(scenario.numberOfNodes);
+        std::vector<std::unique_ptr<PreparedGraph>> graphs(4);
+        runInParallel(graphs.size(), [&](uint32_t i) { graphs[i].reset(new PreparedGraph(network, 2)); });
+        for (auto const& graph : graphs) {
+            ResultVerificator::verifyResults(SingleThreadedPageRankComputer {}.computeForGraph(*graph, scenario.alpha, scenario.iterations, scenario.tolerance),
+                scenario.expectedResult, networkGenerator);
+        }
+    }
+
+    // A graph compressed once is run with its compressed in-links, and still
+    // by every computer, which gets the plain ones decoded.
+    for (auto scenario : scenarios) {
+        auto network = networkGenerator.generateNetworkOfSize(scenario.numberOfNodes);
+        PreparedGraph graph(network, 2);
+        auto numEdges = graph.getNumEdges();
+        auto fingerprint = graph.getFingerprint();
+        graph.compressEdges(2);
+        ASSERT(graph.hasCompressedEdges() && graph.getNumEdges() == numEdges, "Invalid compressed graph, edges=" << graph.getNumEdges());
+        ResultVerificator::verifyResults(MultiThreadedPageRankComputer { 3 }.computeForGraph(graph, scenario.alpha, scenario.iterations, scenario.tolerance),
+            scenario.expectedResult, networkGenerator);
+        for (auto computer : computersToTest) {
+            ResultVerificator::verifyResults(computer->computeForGraph(graph, scenario.alpha, scenario.iterations, scenario.tolerance),
+                scenario.expectedResult, networkGenerator);
+        }
+        ASSERT(graph.getEdges().getNumEdges() == numEdges && graph.getFingerprint() == fingerprint, "Invalid decoded in-links");
+        RankingScheduler scheduler { 2 };
+        ResultVerificator::verifyResults(scheduler.submit(graph, scenario.alpha, scenario.iterations, scenario.tolerance).get().ranks,
+            scenario.expectedResult, networkGenerator);
+        auto sweep = MultiThreadedPageRankComputer { 2 }.computeSweep(graph, { { scenario.alpha, scenario.tolerance } }, scenario.iterations);
+        ResultVerificator::verifyResults(sweep[0], scenario.expectedResult, networkGenerator);
+    }
+
+    // Processes reproduce the threads with the same partition bit for bit.
+    for (uint32_t numParts : { 2, 3, 4 }) {
+        for (auto scenario : scenarios) {
+            auto network = networkGenerator.generateNetworkOfSize(scenario.numberOfNodes);
+            PreparedGraph graph(network, numParts);
+            auto threaded = MultiThreadedPageRankComputer { numParts }.computeForGraph(graph, scenario.alpha, scenario.iterations, scenario.tolerance);
+            auto distributed = DistributedPageRankComputer { numParts }.computeForGraph(graph, scenario.alpha, scenario.iterations, scenario.tolerance);
+            ASSERT(threaded.size() == distributed.size(), "Invalid result size=" << distributed.size());
+            for (uint32_t i = 0; i < threaded.size(); ++i) {
+                ASSERT(PageIdAndRankComparable(threaded[i]).getPageRank() == PageIdAndRankComparable(distributed[i]).getPageRank(),
+                    "Distributed result differs, threaded=" << threaded[i] << ", distributed=" << distributed[i]);
+            }
+        }
+    }
+
+    // A run resumes from the checkpoint left by an earlier one.
+    for (auto scenario : scenarios) {
+        std::string path = "pageRankCalculationTest.checkpoint";
+        std::remove(path.c_str());
+        MultiThreadedPageRankComputer computer { 2, false, { path, 1 } };
+        auto network = networkGenerator.generateNetworkOfSize(scenario.numberOfNodes);
+        PreparedGraph graph(network, 2);
+        ResultVerificator::verifyResults(computer.computeForGraph(graph, scenario.alpha, scenario.iterations, scenario.tolerance), scenario.expectedResult, networkGenerator);
+
+        Checkpoint saved;
+        Checkpoint::Key key { graph.getSize(), graph.getNumEdges(), graph.getFingerprint(), scenario.alpha };
+        ASSERT(Checkpoint::read(path, key, saved) && saved.iteration > 0,
+            "No checkpoint left, numberOfNodes=" << scenario.numberOfNodes);
+        ResultVerificator::verifyResults(computer.computeForGraph(graph, scenario.alpha, scenario.iterations, scenario.tolerance), scenario.expectedResult, networkGenerator);
+
+        // Resumed at the end, a run with a budget has nothing left to do.
+        auto resumed = computer.computeWithBudget(graph, scenario.alpha, saved.iteration, scenario.tolerance, RunBudget());
+        ASSERT(resumed.status.iterations == 0 && resumed.ranks.size() == scenario.numberOfNodes,
+            "Run resumed at the end iterated, iterations=" << resumed.status.iterations);
+
+        // Checkpoints of another graph and truncated ones are started over
+        // and replaced.
+        Checkpoint::Key foreign = key;
+        foreign.fingerprint ^= 1;
+        Checkpoint::write(path, foreign, 1, std::vector<PageRank>(graph.getSize(), 0));
+        ASSERT(not Checkpoint::read(path, key, saved), "Checkpoint of another graph read");
+        ResultVerificator::verifyResults(computer.computeForGraph(graph, scenario.alpha, scenario.iterations, scenario.tolerance), scenario.expectedResult, networkGenerator);
+        ASSERT(Checkpoint::read(path, key, saved), "Checkpoint of another graph not replaced");
+        FILE* truncated = std::fopen(path.c_str(), "wb");
+        std::fputs("PRCK", truncated);
+        std::fclose(truncated);
+        ASSERT(not Checkpoint::read(path, key, saved), "Truncated checkpoint read");
+        ResultVerificator::verifyResults(computer.computeForGraph(graph, scenario.alpha, scenario.iterations, scenario.tolerance), scenario.expectedResult, networkGenerator);
+        std::remove(path.c_str());
+    }
+
+    // Checkpoints that cannot be written fail without stopping the run.
+    for (auto scenario : scenarios) {
+        std::string path = "pageRankCalculationTest.missing/pageRankCalculationTest.checkpoint";
+        auto network = networkGenerator.generateNetworkOfSize(scenario.numberOfNodes);
+        PreparedGraph graph(network, 2);
+        Checkpoint::Key key { graph.getSize(), graph.getNumEdges(), graph.getFingerprint(), scenario.alpha };
+        std::string error;
+        ASSERT(not Checkpoint::write(path, key, 1, std::vector<PageRank>(graph.getSize(), 0), &error) && not error.empty(),
+            "Checkpoint written to a missing directory");
+        MultiThreadedPageRankComputer computer { 2, false, { path, 1 } };
+        ResultVerificator::verifyResults(computer.computeForGraph(graph, scenario.alpha, scenario.iterations, scenario.tolerance), scenario.expectedResult, networkGenerator);
+    }
+
+    // A run with a budget returns converged ranks when the budget suffices,
+    // and the ranks so far when it runs out or is cancelled.
+    for (uint32_t numThreads : { 1, 3 }) {
+        MultiThreadedPageRankComputer multi { numThreads };
+        SingleThreadedPageRankComputer single;
+        for (auto scenario : scenarios) {
+            auto network = networkGenerator.generateNetworkOfSize(scenario.numberOfNodes);
+            PreparedGraph graph(network, numThreads);
+            RunBudget unlimited;
+            for (auto result : { multi.computeWithBudget(graph, scenario.alpha, scenario.iterations, scenario.tolerance, unlimited),
+                     single.computeWithBudget(graph, scenario.alpha, scenario.iterations, scenario.tolerance, unlimited) }) {
+                ASSERT(result.status.converged && result.status.residual < scenario.tolerance, "Run with a budget did not converge");
+                ResultVerificator::verifyResults(result.ranks, scenario.expectedResult, networkGenerator);
+            }
+
+            RunBudget exhausted(std::chrono::seconds(0));
+            for (auto result : { multi.computeWithBudget(graph, scenario.alpha, scenario.iterations, scenario.tolerance, exhausted),
+                     single.computeWithBudget(graph, scenario.alpha, scenario.iterations, scenario.tolerance, exhausted) }) {
+                ASSERT(result.status.iterations == 1 && result.ranks.size() == scenario.numberOfNodes,
+                    "Run out of budget not stopped after the first iteration, iterations=" << result.status.iterations);
+                ASSERT(result.status.converged == (result.status.residual < scenario.tolerance), "Inconsistent status");
+            }
+
+            // No iterations leave the uniform starting ranks.
+            for (auto result : { multi.computeWithBudget(graph, scenario.alpha, 0, scenario.tolerance, unlimited),
+                     single.computeWithBudget(graph, scenario.alpha, 0, scenario.tolerance, unlimited) }) {
+                ASSERT(result.status.iterations == 0 && not result.status.converged && result.ranks.size() == scenario.numberOfNodes,
+                    "Run without iterations iterated, iterations=" << result.status.iterations);
+                for (auto const& pageIdAndRank : result.ranks) {
+                    ASSERT(PageIdAndRankComparable(pageIdAndRank).getPageRank() == 1.0 / scenario.numberOfNodes,
+                        "Run without iterations changed rank=" << pageIdAndRank);
+                }
+            }
+        }
+
+        // Never converges with tolerance 0, stops when cancelled.
+        auto graph = ErdosRenyiNetworkGenerator(idGenerator, 8).generateGraphOfSize(20000);
+        RunBudget cancelled;
+        std::thread canceller([&cancelled] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            cancelled.cancel();
+        });
+        auto result = multi.computeWithBudget(*graph, 0.85, UINT32_MAX, 0, cancelled);
+        canceller.join();
+        ASSERT(not result.status.converged && result.status.iterations > 0 && result.status.iterations < UINT32_MAX && result.ranks.size() == 20000,
+            "Cancelled run not stopped, iterations=" << result.status.iterations << ", residual=" << result.status.residual);
+    }
+
+    // A run in the background reports every iteration, both to the callback
+    // and when polled, and can be cancelled.
+    for (auto scenario : scenarios) {
+        auto network = networkGenerator.generateNetworkOfSize(scenario.numberOfNodes);
+        std::atomic<uint32_t> numCallbacks { 0 };
+        auto run = MultiThreadedPageRankComputer { 3 }.computeAsync(network, scenario.alpha, scenario.iterations, scenario.tolerance,
+            [&numCallbacks](RunProgress::Snapshot const& progress) {
+                ASSERT(progress.iterations == ++numCallbacks, "Iteration reported out of order=" << progress.iterations);
+            });
+        uint32_t polledIterations = 0;
+        while (not run.isReady()) {
+            auto progress = run.getProgress();
+            ASSERT(progress.iterations >= polledIterations, "Polled progress went back");
+            polledIterations = progress.iterations;
+        }
+        auto result = run.get();
+        ASSERT(result.status.converged && result.status.iterations == numCallbacks && run.getProgress().iterations == numCallbacks,
+            "Progress does not match the run, iterations=" << result.status.iterations << ", callbacks=" << numCallbacks);
+        ResultVerificator::verifyResults(result.ranks, scenario.expectedResult, networkGenerator);
+    }
+    {
+        auto graph = ErdosRenyiNetworkGenerator(idGenerator, 8).generateGraphOfSize(20000);
+        auto run = MultiThreadedPageRankComputer { 2 }.computeAsync(*graph, 0.85, UINT32_MAX, 0);
+        while (run.getProgress().iterations == 0) {
+            std::this_thread::yield();
+        }
+        ASSERT(run.getProgress().edgesPerSecond > 0, "No edge rate reported");
+        run.cancel();
+        auto result = run.get();
+        ASSERT(not result.status.converged && result.status.iterations > 0, "Cancelled background run not stopped");
+    }
+
+    // Jobs of all sizes and priorities share one scheduler, the big ones are
+    // split into tasks, and the results are those of the computers.
+    {
+        auto bigGraph = ErdosRenyiNetworkGenerator(idGenerator, 8).generateGraphOfSize(20000);
+        auto bigExpected = SingleThreadedPageRankComputer {}.computeForGraph(*bigGraph, 0.85, 100, 0.0000001);
+        // The same graph as a network, prepared by several threads.
+        auto bigNetwork = ErdosRenyiNetworkGenerator(idGenerator, 8).generateNetworkOfSize(20000);
+        std::vector<Network> networks;
+        for (auto scenario : scenarios)
+            networks.push_back(networkGenerator.generateNetworkOfSize(scenario.numberOfNodes));
+
+        RankingScheduler scheduler { 3 };
+        std::vector<std::future<BestEffortResult>> results, bigResults;
+        for (int priority : { 0, 1 }) {
+            for (uint32_t i = 0; i < scenarios.size(); ++i)
+                results.push_back(scheduler.submit(networks[i], scenarios[i].alpha, scenarios[i].iterations, scenarios[i].tolerance, priority));
+            bigResults.push_back(scheduler.submit(*bigGraph, 0.85, 100, 0.0000001, priority));
+            bigResults.push_back(scheduler.submit(bigNetwork, 0.85, 100, 0.0000001, priority));
+        }
+        for (uint32_t i = 0; i < results.size(); ++i) {
+            auto result = results[i].get();
+            ASSERT(result.status.converged, "Scheduled job did not converge");
+            ResultVerificator::verifyResults(result.ranks, scenarios[i % scenarios.size()].expectedResult, networkGenerator);
+        }
+        for (auto& bigResult : bigResults) {
+            auto result = bigResult.get();
+            ASSERT(result.status.converged && result.ranks.size() == bigExpected.size(), "Scheduled big job did not converge");
+            for (uint32_t i = 0; i < result.ranks.size(); ++i)
+                ASSERT(std::abs(PageIdAndRankComparable(result.ranks[i]).getPageRank() - PageIdAndRankComparable(bigExpected[i]).getPageRank()) < 0.0000001,
+                    "Scheduled big job differs, scheduled=" << result.ranks[i] << ", expected=" << bigExpected[i]);
+        }
+        // A network is prepared again once its jobs are done.
+        auto again = scheduler.submit(networks.back(), scenarios.back().alpha, scenarios.back().iterations, scenarios.back().tolerance).get();
+        ResultVerificator::verifyResults(again.ranks, scenarios.back().expectedResult, networkGenerator);
+
+        // Jobs arriving while their network is being prepared are started
+        // once, by the preparing task.
+        RankingScheduler busy { 4 };
+        auto const& small = scenarios[2];
+        for (uint32_t round = 0; round < 2000; ++round) {
+            std::vector<std::future<BestEffortResult>> sameNetwork;
+            for (uint32_t i = 0; i < 4; ++i)
+                sameNetwork.push_back(busy.submit(networks[2], small.alpha, small.iterations, small.tolerance));
+            for (auto& result : sameNetwork)
+                ResultVerificator::verifyResults(result.get().ranks, small.expectedResult, networkGenerator);
+        }
+    }
+
+    // The automatic plan keeps small graphs on one thread, spreads big ones
+    // over as many threads as still speed them up, compresses only big graphs
+    // on machines where it pays off, and reports what it chose.
+    {
+        MachineCalibration calibration { 8, 1e-9, 2e-9, 20e-6, 5e-6, { 1, 2, 3, 4, 5, 6, 7, 8 } };
+        AutoPageRankComputer::Override automatic { 0, AutoPageRankComputer::Kernel::automatic };
+        auto small = AutoPageRankComputer::plan(100, 300, automatic, calibration);
+        auto big = AutoPageRankComputer::plan(10000000, 100000000, automatic, calibration);
+        ASSERT(small.numThreads == 1 && not small.compressEdges, "Small graph planned with threads=" << small.numThreads);
+        ASSERT(big.numThreads == 8 && not big.compressEdges, "Big graph planned with threads=" << big.numThreads);
+
+        // Threads saturating the memory bandwidth are not worth starting.
+        calibration.speedups = { 1, 1.9, 2.6, 3.0, 3.1, 3.1, 3.1, 3.1 };
+        auto saturated = AutoPageRankComputer::plan(10000000, 100000000, automatic, calibration);
+        ASSERT(saturated.numThreads == 5, "Saturated machine planned with threads=" << saturated.numThreads);
+
+        calibration.compressedSecondsPerUnit = 0.5e-9;
+        ASSERT(AutoPageRankComputer::plan(10000000, 100000000, automatic, calibration).compressEdges, "Big graph not compressed");
+        ASSERT(not AutoPageRankComputer::plan(1000, 10000, automatic, calibration).compressEdges, "Small graph compressed");
+        auto forced = AutoPageRankComputer::plan(10000000, 100000000, { 3, AutoPageRankComputer::Kernel::plain }, calibration);
+        ASSERT(forced.numThreads == 3 && not forced.compressEdges, "Override ignored, threads=" << forced.numThreads);
+
+        std::vector<std::string> messages;
+        AutoPageRankComputer logged { { 2, AutoPageRankComputer::Kernel::plain }, [&messages](std::string const& message) { messages.push_back(message); } };
+        ResultVerificator::verifyResults(
+            logged.computeForNetwork(networkGenerator.generateNetworkOfSize(scenarios[0].numberOfNodes), scenarios[0].alpha, scenarios[0].iterations, scenarios[0].tolerance),
+            scenarios[0].expectedResult, networkGenerator);
+        ASSERT(messages.size() == 1 && messages[0].find("MultiThreadedPageRankComputer[2]") != std::string::npos, "Decision not logged");
+    }
+
+    // A sweep over all scenario parameters of a size gives the same results
+    // as computing them one by one.
+    for (uint32_t numThreads : { 1, 4 }) {
+        MultiThreadedPageRankComputer computer { numThreads };
+        for (auto scenario : scenarios) {
+            std::vector<TestScenario> sameSize;
+            std::vector<PageRankParameters> parameters;
+            for (auto other : scenarios) {
+                if (other.numberOfNodes == scenario.numberOfNodes) {
+                    sameSize.push_back(other);
+                    parameters.push_back({ other.alpha, other.tolerance });
+                }
+            }
+
+            auto results = computer.computeSweep(networkGenerator.generateNetworkOfSize(scenario.numberOfNodes), parameters, scenario.iterations);
+            for (uint32_t i = 0; i < sameSize.size(); ++i) {
+                ResultVerificator::verifyResults(results[i], sameSize[i].expectedResult, networkGenerator);
+            }
+        }
+    }
+
+    // With every page as a seed personalized PageRank is plain PageRank, and
+    // forward push approximates the batched answer for a single seed.
+    for (uint32_t numThreads : { 1, 3 }) {
+        PersonalizedPageRankComputer personalized { numThreads };
+        for (auto scenario : scenarios) {
+            std::vector<PageId> allPages;
+            for (uint32_t i = 0; i < scenario.numberOfNodes; ++i) {
+                allPages.push_back(networkGenerator.generatePageFromNumWithGeneratedId(i).getId());
+            }
+            PageId seed = allPages.back();
+
+            auto results = personalized.computeForSeeds(
+                networkGenerator.generateNetworkOfSize(scenario.numberOfNodes),
+                { allPages, { seed }, allPages },
+                scenario.alpha,
+                scenario.iterations,
+                scenario.tolerance);
+            ResultVerificator::verifyResults(results[0], scenario.expectedResult, networkGenerator);
+            ResultVerificator::verifyResults(results[2], scenario.expectedResult, networkGenerator);
+
+            auto pushed = personalized.computeForwardPush(
+                networkGenerator.generateNetworkOfSize(scenario.numberOfNodes),
+                seed,
+                scenario.alpha,
+                0.0000001);
+            ResultVerificator::verifyResults(results[1], ResultVerificator::ranksByPageNum(pushed, scenario.numberOfNodes, networkGenerator), networkGenerator);
+        }
+    }
+
+    // Orphans and chains hanging off them are solved before iterating, chains
+    // leading to dangling pages after it, only the cycle is iterated.
+    {
+        // 0 -> 1 -> 2 <-> 3 -> 4 -> 5, 2 -> 5, and 6 alone.
+        std::vector<std::vector<uint32_t>> links = { { 1 }, { 2 }, { 3, 5 }, { 2, 4 }, { 5 }, {}, {} };
+        Network network(idGenerator);
+        for (uint32_t i = 0; i < links.size(); ++i) {
+            Page page = networkGenerator.generatePageFromNum(i);
+            for (auto link : links[i])
+                page.addLink(networkGenerator.generatePageFromNumWithGeneratedId(link).getId());
+            network.addPage(page);
+        }
+        PreparedGraph graph(network, 2);
+        PresolvedGraph presolved(graph, 2);
+        ASSERT((presolved.getUpstream() == std::vector<PageIndex> { 0, 6, 1 } && presolved.getUpstreamLayers() == std::vector<size_t> { 0, 2, 3 }),
+            "Invalid upstream pages");
+        ASSERT((presolved.getDownstream() == std::vector<PageIndex> { 5, 4 } && presolved.getDownstreamLayers() == std::vector<size_t> { 0, 1, 2 }),
+            "Invalid downstream pages");
+        ASSERT((presolved.getCorePages() == std::vector<PageIndex> { 2, 3 } && presolved.getCoreEdges().getNumEdges() == 2), "Invalid core");
+        PresolvedGraph unpeeled(graph, 2, false);
+        ASSERT(unpeeled.getUpstream().empty() && unpeeled.getDownstream() == std::vector<PageIndex>({ 5, 6 }) && unpeeled.getCorePages().size() == 5,
+            "Invalid pages without presolve");
+
+        auto expected = ResultVerificator::ranksByPageNum(SingleThreadedPageRankComputer {}.computeForGraph(graph, 0.85, 100, 0.0000001), links.size(), networkGenerator);
+        for (uint32_t numThreads : { 1, 3 })
+            ResultVerificator::verifyResults(LumpedPageRankComputer { numThreads }.computeForGraph(graph, 0.85, 100, 0.0000001), expected, networkGenerator);
+
+        // The cycle is the only component of several pages, 5 comes after 4.
+        SccDecomposition scc(graph, 2);
+        ASSERT((scc.getPages() == std::vector<PageIndex> { 0, 6, 1, 2, 3, 4, 5 } && scc.getComponents() == std::vector<size_t> { 0, 1, 2, 3, 5, 6, 7 }
+                   && scc.getLevels() == std::vector<size_t> { 0, 2, 3, 4, 5, 6 }),
+            "Invalid components");
+        ASSERT(scc.getComponentOf()[2] == scc.getComponentOf()[3] && scc.getNumInnerLinks()[2] == 1 && scc.getNumInnerLinks()[4] == 0, "Invalid cycle");
+    }
+
+    // Random generators give the same graph for any number of threads, both
+    // as a network and emitted straight into a prepared graph.
+    uint32_t randomSize = 3000;
+    std::vector<std::shared_ptr<RandomNetworkGenerator>> randomGenerators[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+        uint32_t numThreads = i == 0 ? 1 : 3;
+        randomGenerators[i] = {
+            std::make_shared<ErdosRenyiNetworkGenerator>(idGenerator, 8, 7, numThreads),
+            std::make_shared<RmatNetworkGenerator>(idGenerator, 8, 7, numThreads),
+            std::make_shared<BarabasiAlbertNetworkGenerator>(idGenerator, 8, 7, numThreads),
+            std::make_shared<ClusterChainNetworkGenerator>(idGenerator, 8, 30, 4, 7, numThreads),
+        };
+    }
+    for (uint32_t g = 0; g < randomGenerators[0].size(); ++g) {
+        auto graph = randomGenerators[0][g]->generateGraphOfSize(randomSize);
+        auto threadedGraph = randomGenerators[1][g]->generateGraphOfSize(randomSize);
+        ASSERT(graph->getNumLinks() == threadedGraph->getNumLinks()
+                && graph->getEdges().getOffsets() == threadedGraph->getEdges().getOffsets()
+                && graph->getEdges().getSources() == threadedGraph->getEdges().getSources(),
+            "Generated graph depends on the number of threads, generator=" << g);
+        ASSERT(graph->getEdges().getNumEdges() > 6 * randomSize && graph->getEdges().getNumEdges() < 10 * randomSize,
+            "Unexpected number of edges=" << graph->getEdges().getNumEdges() << ", generator=" << g);
+        // Out-links come out the same for any number of threads.
+        auto outLinks = graph->getEdges().transposed(1);
+        auto threadedOutLinks = graph->getEdges().transposed(3);
+        ASSERT(outLinks.getOffsets() == threadedOutLinks.getOffsets() && outLinks.getSources() == threadedOutLinks.getSources()
+                && outLinks.getNumEdges() == graph->getEdges().getNumEdges(),
+            "Transposed graph depends on the number of threads, generator=" << g);
+
+        auto expected = ResultVerificator::ranksByPageNum(
+            SingleThreadedPageRankComputer {}.computeForGraph(*graph, 0.85, 100, 0.0000001), randomSize, *randomGenerators[0][g]);
+        ResultVerificator::verifyResults(
+            MultiThreadedPageRankComputer { 3 }.computeForNetwork(randomGenerators[1][g]->generateNetworkOfSize(randomSize), 0.85, 100, 0.0000001),
+            expected, *randomGenerators[1][g]);
+        // Barabasi-Albert graphs only link back, so presolve leaves no core.
+        ASSERT(g != 2 || PresolvedGraph(*graph, 1).getCorePages().empty(), "Core left of a graph without cycles");
+        ResultVerificator::verifyResults(LumpedPageRankComputer { 3 }.computeForGraph(*graph, 0.85, 100, 0.0000001), expected, *randomGenerators[0][g]);
+        ResultVerificator::verifyResults(SccPageRankComputer { 3 }.computeForGraph(*graph, 0.85, 100, 0.0000001), expected, *randomGenerators[0][g]);
+        // Clusters are components of their own, one level each.
+        SccDecomposition scc(*graph, 3);
+        ASSERT(g != 3 || (scc.getComponents().size() == randomSize / 30 + 1 && scc.getLevels().size() == randomSize / 30 + 1), "Clusters not found");
+    }
+
+    // Levels and components of at least minParallelPages pages are spread
+    // over the threads: the orphans of an R-MAT graph, and big clusters.
+    {
+        RmatNetworkGenerator rmatGenerator(idGenerator, 8, 7);
+        ClusterChainNetworkGenerator clusterChainGenerator(idGenerator, 8, 5000, 2, 7);
+        for (RandomNetworkGenerator const* generator : std::vector<RandomNetworkGenerator const*> { &rmatGenerator, &clusterChainGenerator }) {
+            auto graph = generator->generateGraphOfSize(20000);
+            auto expected = ResultVerificator::ranksByPageNum(SingleThreadedPageRankComputer {}.computeForGraph(*graph, 0.85, 100, 0.0000001), 20000, *generator);
+            ResultVerificator::verifyResults(SccPageRankComputer { 3 }.computeForGraph(*graph, 0.85, 100, 0.0000001), expected, *generator);
+        }
+    }
+
     return 0;
 }
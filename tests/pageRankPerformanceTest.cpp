@@ -1,46 +1,421 @@
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
 #include "../src/immutable/common.hpp"
 #include "../src/immutable/pageIdAndRank.hpp"
 
+#include "../src/autoPageRankComputer.hpp"
+#include "../src/distributedPageRankComputer.hpp"
+#include "../src/lumpedPageRankComputer.hpp"
+#include "../src/monteCarloPageRankComputer.hpp"
 #include "../src/multiThreadedPageRankComputer.hpp"
+#include "../src/rankingScheduler.hpp"
+#include "../src/sccPageRankComputer.hpp"
 #include "../src/singleThreadedPageRankComputer.hpp"
 
+#include "./lib/benchmark.hpp"
 #include "./lib/networkGenerator.hpp"
-#include "./lib/performanceTimer.hpp"
 #include "./lib/resultVerificator.hpp"
+#include "./lib/samplingProfiler.hpp"
 #include "./lib/simpleIdGenerator.hpp"
 
-void pageRankComputationWithNumNodes(uint32_t num, PageRankComputer const& computer, NetworkGenerator const& networkGenerator)
+// Benchmarks of every stage of a computation, named
+// <stage>/<generator>/<number of pages>/<variant>. See BenchmarkSuite for
+// the command line, results go to pageRankPerformanceTest.json next to the
+// executable by default.
+
+struct GraphParameters {
+    std::string generatorName;
+    NetworkGenerator const* generator;
+    uint32_t numPages;
+
+    std::string name() const
+    {
+        return this->generatorName + "/" + std::to_string(this->numPages);
+    }
+};
+
+// A prepared graph set up once per benchmark. Random networks are emitted
+// straight into the graph, other ones are prepared from their network.
+struct PreparedNetwork {
+    std::unique_ptr<Network> network;
+    std::unique_ptr<PreparedGraph> graph;
+
+    PreparedNetwork(GraphParameters const& parameters, uint32_t numThreads)
+        : network()
+        , graph()
+    {
+        auto randomGenerator = dynamic_cast<RandomNetworkGenerator const*>(parameters.generator);
+        if (randomGenerator != nullptr) {
+            graph = randomGenerator->generateGraphOfSize(parameters.numPages);
+        } else {
+            network.reset(new Network(parameters.generator->generateNetworkOfSize(parameters.numPages)));
+            graph.reset(new PreparedGraph(*network, numThreads));
+        }
+    }
+};
+
+// Rough footprint of a materialized result: the entries and their id strings.
+size_t resultBytes(std::vector<PageIdAndRank> const& result)
+{
+    size_t bytes = result.capacity() * sizeof(PageIdAndRank);
+    for (auto const& pageIdAndRank : result) {
+        std::ostringstream id;
+        id << PageIdAndRankComparable(pageIdAndRank).getPageId();
+        bytes += id.str().size();
+    }
+    return bytes;
+}
+
+// Generating the ids of fresh pages, the networks are generated untimed.
+void addIdGeneration(BenchmarkSuite& suite, GraphParameters const& parameters, uint32_t numThreads)
+{
+    suite.add("idGeneration/" + parameters.name() + "/threads:" + std::to_string(numThreads), [parameters, numThreads] {
+        return [parameters, numThreads](BenchmarkRun& run) {
+            Network network = parameters.generator->generateNetworkOfSize(parameters.numPages);
+            auto const& pages = network.getPages();
+            run.time([&] {
+                runInParallel(numThreads, [&](uint32_t thread) {
+                    auto end = segmentEnd(pages.size(), numThreads, thread);
+                    for (auto i = segmentBegin(pages.size(), numThreads, thread); i < end; ++i)
+                        pages[i].generateId(network.getGenerator());
+                });
+            });
+        };
+    });
+}
+
+// Generating a random graph straight into a PreparedGraph.
+void addGeneration(BenchmarkSuite& suite, GraphParameters const& parameters)
+{
+    suite.add("generation/" + parameters.name(), [parameters] {
+        return [parameters](BenchmarkRun& run) {
+            auto randomGenerator = dynamic_cast<RandomNetworkGenerator const*>(parameters.generator);
+            std::unique_ptr<PreparedGraph> graph;
+            run.time([&] { graph = randomGenerator->generateGraphOfSize(parameters.numPages); });
+            run.counter("edges", graph->getEdges().getNumEdges());
+        };
+    });
+}
+
+// Indexing and edge building. Ids are generated by the warmup and reused.
+void addSetup(BenchmarkSuite& suite, GraphParameters const& parameters, uint32_t numThreads)
+{
+    suite.add("setup/" + parameters.name() + "/threads:" + std::to_string(numThreads), [parameters, numThreads] {
+        auto network = std::make_shared<Network>(parameters.generator->generateNetworkOfSize(parameters.numPages));
+        return [network, numThreads](BenchmarkRun& run) {
+            std::unique_ptr<PreparedGraph> graph;
+            run.time([&] { graph.reset(new PreparedGraph(*network, numThreads)); });
+            run.counter("edges", graph->getEdges().getNumEdges());
+        };
+    });
+}
+
+// Iterations only, on a graph prepared (and with compressEdges compressed) once.
+// Computers running the power iteration take as many iterations as the
+// single threaded one, counted untimed, and report the in-links they visit;
+// the others only the size of the graph.
+void addIteration(BenchmarkSuite& suite, GraphParameters const& parameters, std::shared_ptr<PageRankComputer> computer, bool powerIteration,
+    bool compressEdges = false)
+{
+    suite.add("iteration/" + parameters.name() + "/" + computer->getName(), [parameters, computer, powerIteration, compressEdges] {
+        auto prepared = std::make_shared<PreparedNetwork>(parameters, 4);
+        uint32_t iterations = 0;
+        if (powerIteration) {
+            RunBudget unlimited;
+            iterations = SingleThreadedPageRankComputer {}.computeWithBudget(*prepared->graph, 0.85, 100, 0.0000001, unlimited).status.iterations;
+        }
+        if (compressEdges)
+            prepared->graph->compressEdges(4);
+        return [prepared, computer, iterations](BenchmarkRun& run) {
+            std::vector<PageIdAndRank> result;
+            run.time([&] { result = computer->computeForGraph(*prepared->graph, 0.85, 100, 0.0000001); });
+            ASSERT(result.size() == prepared->graph->getSize(), "Invalid result size=" << result.size());
+            if (iterations > 0) {
+                run.counter("edges", prepared->graph->getNumEdges());
+                run.counter("iterations", iterations);
+            } else {
+                run.counter("inLinks", prepared->graph->getNumEdges());
+            }
+        };
+    });
+}
+
+// computeForNetwork on a fresh network: ids, setup and iterations.
+void addEndToEnd(BenchmarkSuite& suite, GraphParameters const& parameters, std::shared_ptr<PageRankComputer> computer)
+{
+    suite.add("endToEnd/" + parameters.name() + "/" + computer->getName(), [parameters, computer] {
+        return [parameters, computer](BenchmarkRun& run) {
+            Network network = parameters.generator->generateNetworkOfSize(parameters.numPages);
+            std::vector<PageIdAndRank> result;
+            run.time([&] { result = computer->computeForNetwork(network, 0.85, 100, 0.0000001); });
+            ASSERT(result.size() == network.getSize(), "Invalid result size=" << result.size());
+        };
+    });
+}
+
+// The k best pages from a full sorted result and from computeTopKForGraph.
+void addTopK(BenchmarkSuite& suite, GraphParameters const& parameters, uint32_t k, std::shared_ptr<PageRankComputer> computer)
+{
+    std::string name = parameters.name() + "/k:" + std::to_string(k) + "/" + computer->getName();
+    suite.add("fullSort/" + name, [parameters, computer] {
+        auto prepared = std::make_shared<PreparedNetwork>(parameters, 4);
+        return [prepared, computer](BenchmarkRun& run) {
+            std::vector<PageIdAndRank> full;
+            run.time([&] {
+                full = computer->computeForGraph(*prepared->graph, 0.85, 100, 0.0000001);
+                std::sort(full.begin(), full.end(), [](PageIdAndRank const& a, PageIdAndRank const& b) {
+                    return PageIdAndRankComparable(a).getPageRank() > PageIdAndRankComparable(b).getPageRank();
+                });
+            });
+            run.counter("resultBytes", resultBytes(full));
+        };
+    });
+    suite.add("topK/" + name, [parameters, k, computer] {
+        auto prepared = std::make_shared<PreparedNetwork>(parameters, 4);
+        return [prepared, k, computer](BenchmarkRun& run) {
+            std::vector<PageIdAndRank> topK;
+            run.time([&] { topK = computer->computeTopKForGraph(*prepared->graph, 0.85, 100, 0.0000001, k); });
+            ASSERT(topK.size() == std::min<size_t>(k, prepared->graph->getSize()), "Invalid top size=" << topK.size());
+            run.counter("resultBytes", resultBytes(topK));
+        };
+    });
+}
+
+// Monte Carlo ranks, with their error against the exact single threaded ones.
+void addMonteCarlo(BenchmarkSuite& suite, GraphParameters const& parameters, std::shared_ptr<MonteCarloPageRankComputer> computer)
 {
-    Network network = networkGenerator.generateNetworkOfSize(num);
-    PerformanceTimer timer;
-    std::vector<PageIdAndRank> result = computer.computeForNetwork(network, 0.85, 100, 0.0000001);
-    timer.printTimeDifference("PageRank Performance Test [" + std::to_string(num) + " nodes, " + computer.getName() + "]");
+    suite.add("monteCarlo/" + parameters.name() + "/" + computer->getName(), [parameters, computer] {
+        auto prepared = std::make_shared<PreparedNetwork>(parameters, 4);
+        auto exact = std::make_shared<std::vector<PageRank>>(ResultVerificator::ranksByPageNum(
+            SingleThreadedPageRankComputer {}.computeForGraph(*prepared->graph, 0.85, 100, 0.0000001), parameters.numPages, *parameters.generator));
+        return [parameters, prepared, exact, computer](BenchmarkRun& run) {
+            std::vector<PageIdAndRank> approximate;
+            run.time([&] { approximate = computer->computeForGraph(*prepared->graph, 0.85, 100, 0.0000001); });
 
-    ASSERT(result.size() == network.getSize(), "Invalid result size=" << result.size());
+            auto approximateRanks = ResultVerificator::ranksByPageNum(approximate, parameters.numPages, *parameters.generator);
+            double l1Error = 0, maxRelativeError = 0;
+            for (uint32_t i = 0; i < parameters.numPages; ++i) {
+                l1Error += std::abs((*exact)[i] - approximateRanks[i]);
+                maxRelativeError = std::max(maxRelativeError, std::abs((*exact)[i] - approximateRanks[i]) / (*exact)[i]);
+            }
+            run.counter("l1Error", l1Error);
+            run.counter("maxRelativeError", maxRelativeError);
+        };
+    });
 }
 
-int main()
+// Several alphas one by one, then as a single sweep.
+void addSweep(BenchmarkSuite& suite, GraphParameters const& parameters, std::vector<double> const& alphas, uint32_t numThreads)
 {
-    SingleThreadedPageRankComputer computer;
+    std::string name = parameters.name() + "/alphas:" + std::to_string(alphas.size()) + "/threads:" + std::to_string(numThreads);
+    suite.add("separateAlphas/" + name, [parameters, alphas, numThreads] {
+        auto prepared = std::make_shared<PreparedNetwork>(parameters, numThreads);
+        return [prepared, alphas, numThreads](BenchmarkRun& run) {
+            MultiThreadedPageRankComputer computer { numThreads };
+            run.time([&] {
+                for (auto alpha : alphas)
+                    computer.computeForGraph(*prepared->graph, alpha, 100, 0.0000001);
+            });
+        };
+    });
+    suite.add("sweep/" + name, [parameters, alphas, numThreads] {
+        auto prepared = std::make_shared<PreparedNetwork>(parameters, numThreads);
+        return [prepared, alphas, numThreads](BenchmarkRun& run) {
+            std::vector<PageRankParameters> sweepParameters;
+            for (auto alpha : alphas)
+                sweepParameters.push_back({ alpha, 0.0000001 });
+            std::vector<std::vector<PageIdAndRank>> results;
+            run.time([&] { results = MultiThreadedPageRankComputer { numThreads }.computeSweep(*prepared->graph, sweepParameters, 100); });
+            ASSERT(results.size() == alphas.size(), "Invalid sweep size=" << results.size());
+        };
+    });
+}
+
+// Compressing the in-links, with the sizes of both layouts.
+void addCompression(BenchmarkSuite& suite, GraphParameters const& parameters, uint32_t numThreads)
+{
+    suite.add("compression/" + parameters.name() + "/threads:" + std::to_string(numThreads), [parameters, numThreads] {
+        auto prepared = std::make_shared<PreparedNetwork>(parameters, numThreads);
+        return [prepared, numThreads](BenchmarkRun& run) {
+            std::unique_ptr<CompressedCsrGraph> compressed;
+            run.time([&] { compressed.reset(new CompressedCsrGraph(prepared->graph->getEdges(), numThreads)); });
+            run.counter("plainBytes", prepared->graph->getEdges().getSizeInBytes());
+            run.counter("compressedBytes", compressed->getSizeInBytes());
+        };
+    });
+}
+
+// Runs saving a checkpoint every `everyIterations` (0 for none).
+void addCheckpoint(BenchmarkSuite& suite, GraphParameters const& parameters, uint32_t numThreads, uint32_t everyIterations)
+{
+    std::string name = parameters.name() + "/threads:" + std::to_string(numThreads) + "/every:" + std::to_string(everyIterations);
+    suite.add("checkpoint/" + name, [parameters, numThreads, everyIterations] {
+        auto prepared = std::make_shared<PreparedNetwork>(parameters, numThreads);
+        return [prepared, numThreads, everyIterations](BenchmarkRun& run) {
+            std::string path = "pageRankPerformanceTest.checkpoint";
+            MultiThreadedPageRankComputer computer { numThreads, false, { path, everyIterations } };
+            run.time([&] { computer.computeForGraph(*prepared->graph, 0.85, 100, 0.0000001); });
+            std::remove(path.c_str());
+        };
+    });
+    if (everyIterations == 0)
+        return;
+    suite.add("checkpointOffer/" + parameters.name(), [parameters] {
+        return [parameters](BenchmarkRun& run) {
+            std::string path = "pageRankPerformanceTest.checkpoint";
+            std::vector<PageRank> pageRanks(parameters.numPages, 1.0 / parameters.numPages);
+            {
+                CheckpointWriter writer(path, { parameters.numPages, 0, 0, 0.85 });
+                run.time([&] { writer.offer(1, pageRanks); });
+            }
+            std::remove(path.c_str());
+        };
+    });
+}
+
+// Many jobs of different sizes at once, `count` of each graph: each job
+// with threads of its own, or all of them on one shared scheduler.
+void addJobMix(BenchmarkSuite& suite, std::vector<std::pair<GraphParameters, uint32_t>> const& mix, uint32_t numThreads)
+{
+    uint32_t numJobs = 0;
+    for (auto const& graphAndCount : mix)
+        numJobs += graphAndCount.second;
+    std::string name = "jobs:" + std::to_string(numJobs) + "/threads:" + std::to_string(numThreads);
+    auto prepareJobs = [mix, numThreads] {
+        std::vector<std::shared_ptr<PreparedNetwork>> jobs;
+        for (auto const& graphAndCount : mix) {
+            auto prepared = std::make_shared<PreparedNetwork>(graphAndCount.first, numThreads);
+            jobs.insert(jobs.end(), graphAndCount.second, prepared);
+        }
+        return jobs;
+    };
+
+    suite.add("jobMix/" + name + "/ownThreads", [prepareJobs, numThreads] {
+        auto jobs = prepareJobs();
+        return [jobs, numThreads](BenchmarkRun& run) {
+            run.time([&] {
+                std::vector<ThreadRAII> threads;
+                for (auto const& job : jobs) {
+                    auto work = [&job, numThreads] { MultiThreadedPageRankComputer { numThreads }.computeForGraph(*job->graph, 0.85, 100, 0.0000001); };
+                    threads.push_back({ std::thread { work }, ThreadRAII::DtorAction::join });
+                }
+            });
+            run.counter("jobsPerSecond", jobs.size() / run.getSeconds());
+        };
+    });
+    suite.add("jobMix/" + name + "/scheduler", [prepareJobs, numThreads] {
+        auto jobs = prepareJobs();
+        auto scheduler = std::make_shared<RankingScheduler>(numThreads);
+        return [jobs, scheduler](BenchmarkRun& run) {
+            run.time([&] {
+                std::vector<std::future<BestEffortResult>> results;
+                for (auto const& job : jobs)
+                    results.push_back(scheduler->submit(*job->graph, 0.85, 100, 0.0000001));
+                for (auto& result : results)
+                    ASSERT(result.get().status.converged, "Job did not converge");
+            });
+            run.counter("jobsPerSecond", jobs.size() / run.getSeconds());
+        };
+    });
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkSuite suite(argc, argv, "pageRankPerformanceTest.json");
+
     SimpleIdGenerator simpleIdGenerator("2000f1ffa5ce95d0f1e1893598e6aeeb2c214c85a88e3569d62c2dccd06a8725");
     SimpleNetworkGenerator simpleNetworkGenerator(simpleIdGenerator);
+    NetworkWithoutManyEdgesGenerator networkWithoutEdgesGenerator(simpleIdGenerator);
 
-    pageRankComputationWithNumNodes(100, computer, simpleNetworkGenerator);
-    pageRankComputationWithNumNodes(1000, computer, simpleNetworkGenerator);
-    pageRankComputationWithNumNodes(2000, computer, simpleNetworkGenerator);
+    std::vector<GraphParameters> denseGraphs = { { "simple", &simpleNetworkGenerator, 1000 }, { "simple", &simpleNetworkGenerator, 2000 } };
+    std::vector<GraphParameters> sparseGraphs = { { "withoutManyEdges", &networkWithoutEdgesGenerator, 100000 }, { "withoutManyEdges", &networkWithoutEdgesGenerator, 500000 } };
+    std::vector<GraphParameters> allGraphs(denseGraphs);
+    allGraphs.insert(allGraphs.end(), sparseGraphs.begin(), sparseGraphs.end());
+    std::vector<uint32_t> threadCounts = { 1, 2, 4, 8 };
 
-    pageRankComputationWithNumNodes(2000, MultiThreadedPageRankComputer { 1 }, simpleNetworkGenerator);
-    pageRankComputationWithNumNodes(2000, MultiThreadedPageRankComputer { 2 }, simpleNetworkGenerator);
-    pageRankComputationWithNumNodes(2000, MultiThreadedPageRankComputer { 3 }, simpleNetworkGenerator);
-    pageRankComputationWithNumNodes(2000, MultiThreadedPageRankComputer { 4 }, simpleNetworkGenerator);
-    pageRankComputationWithNumNodes(2000, MultiThreadedPageRankComputer { 8 }, simpleNetworkGenerator);
+    // Power law and uniform graphs of 10M links.
+    ErdosRenyiNetworkGenerator erdosRenyiGenerator(simpleIdGenerator, 10, 2021, 4);
+    RmatNetworkGenerator rmatGenerator(simpleIdGenerator, 10, 2021, 4);
+    BarabasiAlbertNetworkGenerator barabasiAlbertGenerator(simpleIdGenerator, 10, 2021, 4);
+    // A chain of 10k components, deep unlike the others.
+    ClusterChainNetworkGenerator clusterChainGenerator(simpleIdGenerator, 10, 100, 4, 2021, 4);
+    std::vector<GraphParameters> randomGraphs = { { "erdosRenyi", &erdosRenyiGenerator, 1000000 }, { "rmat", &rmatGenerator, 1000000 },
+        { "barabasiAlbert", &barabasiAlbertGenerator, 1000000 }, { "clusterChain", &clusterChainGenerator, 1000000 } };
 
-    NetworkWithoutManyEdgesGenerator networkWithoutEdgesGenerator(simpleIdGenerator);
-    pageRankComputationWithNumNodes(500000, computer, networkWithoutEdgesGenerator);
-    pageRankComputationWithNumNodes(500000, MultiThreadedPageRankComputer { 1 }, networkWithoutEdgesGenerator);
-    pageRankComputationWithNumNodes(500000, MultiThreadedPageRankComputer { 2 }, networkWithoutEdgesGenerator);
-    pageRankComputationWithNumNodes(500000, MultiThreadedPageRankComputer { 3 }, networkWithoutEdgesGenerator);
-    pageRankComputationWithNumNodes(500000, MultiThreadedPageRankComputer { 4 }, networkWithoutEdgesGenerator);
-    pageRankComputationWithNumNodes(500000, MultiThreadedPageRankComputer { 8 }, networkWithoutEdgesGenerator);
+    // Id generation only depends on the number of pages.
+    for (auto const& graph : sparseGraphs)
+        for (auto numThreads : threadCounts)
+            addIdGeneration(suite, graph, numThreads);
+
+    for (auto const& graph : allGraphs)
+        for (auto numThreads : threadCounts)
+            addSetup(suite, graph, numThreads);
+
+    // Every computer runs on all graphs, those also on random graphs are
+    // collected in randomGraphComputers.
+    std::vector<std::shared_ptr<PageRankComputer>> computers;
+    std::vector<std::shared_ptr<PageRankComputer>> randomGraphComputers;
+    auto addComputer = [&computers, &randomGraphComputers](std::shared_ptr<PageRankComputer> computer, bool onRandomGraphs) {
+        computers.push_back(computer);
+        if (onRandomGraphs)
+            randomGraphComputers.push_back(computer);
+    };
+    auto singleThreadedComputer = std::make_shared<SingleThreadedPageRankComputer>();
+    addComputer(singleThreadedComputer, true);
+    for (auto numThreads : threadCounts)
+        addComputer(std::make_shared<MultiThreadedPageRankComputer>(numThreads), numThreads == 4);
+    auto compressedComputer = std::make_shared<MultiThreadedPageRankComputer>(4, true);
+    addComputer(compressedComputer, true);
+    addComputer(std::make_shared<DistributedPageRankComputer>(2), false);
+    addComputer(std::make_shared<DistributedPageRankComputer>(4), true);
+    addComputer(std::make_shared<AutoPageRankComputer>(), true);
+    // The computers so far run the power iteration.
+    auto powerIterationEnd = computers.size();
+    auto isPowerIteration = [&computers, powerIterationEnd](std::shared_ptr<PageRankComputer> const& computer) {
+        return std::find(computers.begin(), computers.begin() + powerIterationEnd, computer) != computers.begin() + powerIterationEnd;
+    };
+    addComputer(std::make_shared<LumpedPageRankComputer>(1), false);
+    addComputer(std::make_shared<LumpedPageRankComputer>(4), true);
+    addComputer(std::make_shared<LumpedPageRankComputer>(4, false), true);
+    addComputer(std::make_shared<SccPageRankComputer>(1), true);
+    addComputer(std::make_shared<SccPageRankComputer>(4), true);
+    for (auto const& graph : allGraphs)
+        for (auto computer : computers)
+            addIteration(suite, graph, computer, isPowerIteration(computer), computer == compressedComputer);
+
+    for (auto const& graph : randomGraphs) {
+        addGeneration(suite, graph);
+        for (auto computer : randomGraphComputers)
+            addIteration(suite, graph, computer, isPowerIteration(computer), computer == compressedComputer);
+    }
+
+    for (auto const& graph : allGraphs) {
+        addEndToEnd(suite, graph, singleThreadedComputer);
+        addEndToEnd(suite, graph, std::make_shared<MultiThreadedPageRankComputer>(4));
+    }
+
+    addTopK(suite, sparseGraphs.back(), 1000, singleThreadedComputer);
+    addTopK(suite, sparseGraphs.back(), 1000, std::make_shared<MultiThreadedPageRankComputer>(4));
+
+    addMonteCarlo(suite, denseGraphs[0], std::make_shared<MonteCarloPageRankComputer>(4, 100000));
+    addMonteCarlo(suite, denseGraphs[0], std::make_shared<MonteCarloPageRankComputer>(4, 1000000));
+    addMonteCarlo(suite, sparseGraphs[0], std::make_shared<MonteCarloPageRankComputer>(4, 10000000));
+
+    addSweep(suite, denseGraphs.back(), { 0.15, 0.5, 0.85, 0.9 }, 4);
+    addSweep(suite, sparseGraphs.back(), { 0.15, 0.5, 0.85, 0.9 }, 4);
+
+    for (auto const& graph : allGraphs)
+        addCompression(suite, graph, 4);
+
+    addCheckpoint(suite, sparseGraphs.back(), 4, 0);
+    addCheckpoint(suite, sparseGraphs.back(), 4, 1);
+
+    std::vector<std::pair<GraphParameters, uint32_t>> jobMix = { { denseGraphs[0], 16 }, { denseGraphs[1], 8 }, { sparseGraphs[0], 4 }, { sparseGraphs[1], 2 } };
+    for (auto numThreads : { 4, 8 })
+        addJobMix(suite, jobMix, numThreads);
+
+    suite.run();
     return 0;
 }
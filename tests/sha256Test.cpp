@@ -3,6 +3,8 @@
 
 #include "../src/sha256IdGenerator.hpp"
 
+#include "./lib/samplingProfiler.hpp"
+
 void testSha256(std::string const& testScenario, std::string const& expectedResult)
 {
     Sha256IdGenerator generator;
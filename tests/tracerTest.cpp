@@ -0,0 +1,35 @@
+#include <sstream>
+#include <string>
+
+#include "../src/immutable/common.hpp"
+#include "../src/multiThreadedPageRankComputer.hpp"
+#include "../src/tracer.hpp"
+
+#include "./lib/networkGenerator.hpp"
+#include "./lib/samplingProfiler.hpp"
+#include "./lib/simpleIdGenerator.hpp"
+
+// Traced runs put the phases and barrier waits of every worker on its track.
+int main()
+{
+    SimpleIdGenerator idGenerator("b7628d82a284526971095162ba34be8bc05c6e06b9face83b46c2813f7f2157b");
+    SimpleNetworkGenerator networkGenerator(idGenerator);
+    MultiThreadedPageRankComputer computer { 3 };
+
+    Tracer::clear();
+    auto result = computer.computeForNetwork(networkGenerator.generateNetworkOfSize(100), 0.85, 100, 0.0000001);
+    ASSERT(result.size() == 100, "Invalid result size=" << result.size());
+
+    std::ostringstream out;
+    Tracer::writeChromeTrace(out);
+    std::string trace = out.str();
+    ASSERT(trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") == 0 && trace.find("\n]}") != std::string::npos,
+        "Invalid JSON=" << trace.substr(0, 200));
+    for (std::string track : { "master", "worker 0", "worker 1", "worker 2" })
+        ASSERT(trace.find("\"args\":{\"name\":\"" + track + "\"}") != std::string::npos, "Missing track=" << track);
+    for (std::string span : { "setup", "dangleSum", "barrier", "edges", "copy", "wait", "difference" })
+        ASSERT(trace.find("{\"name\":\"" + span + "\",\"ph\":\"X\"") != std::string::npos, "Missing span=" << span);
+    ASSERT(trace.find("\"args\":{\"iteration\":1}") != std::string::npos, "Missing iterations");
+
+    return 0;
+}
@@ -3,4 +3,10 @@
 
 input=$1
 output=$2
-cat $1 | ./FlameGraph/stackcollapse-gdb.pl | ./FlameGraph/flamegraph.pl > $2
+# Folded stacks of profileProgram.sh go straight to flamegraph.pl, older gdb
+# dumps are collapsed first.
+if grep -q "^Thread \|^#[0-9]" $input; then
+	cat $input | ./FlameGraph/stackcollapse-gdb.pl | ./FlameGraph/flamegraph.pl > $output
+else
+	./FlameGraph/flamegraph.pl $input > $output
+fi
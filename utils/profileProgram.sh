@@ -1,30 +1,25 @@
 #!/bin/bash
-# Profiler based on http://poormansprofiler.org/
+# Samples the program with the profiler built into the test binaries
+# (tests/lib/samplingProfiler.hpp) and writes folded stacks, the input of
+# FlameGraph/flamegraph.pl. Only time spent running is sampled, threads
+# waiting on a barrier do not show.
 
 programToProfile=$1
 outputName=$2
 
-sleeptime=0.1
+# Samples per second of CPU time of every thread.
+export PAGERANK_PROFILE_HZ=${PAGERANK_PROFILE_HZ:-1000}
+export PAGERANK_PROFILE=$outputName
 
-# Sample stack traces:
-
-
-echo "" > $outputName #make file empty
 echo "Started profiling"
 
 # Support input redirection, example:
-# ./utils/profileProgram.sh "./tests/e2eTest 4" output.gdb tests/e2eScenario.txt
+# ./utils/profileProgram.sh "./tests/e2eTest 4" output.folded tests/e2eScenario.txt
 if [ "$#" -ne 3 ]; then
-	$programToProfile & 
+	$programToProfile
 else
 	echo $3
-	$programToProfile < $3 &
+	$programToProfile < $3
 fi
 
-pid=$!
-while kill -0 $pid 2> /dev/null; do
-	gdb -ex "set pagination 0" -ex "thread apply all bt" -batch -p $pid >> $outputName 2> /dev/null
-	sleep $sleeptime
-done
-
-echo "Stopped profiling"
\ No newline at end of file
+echo "Stopped profiling"